@@ -5,7 +5,26 @@ attribute vec4 color;
 attribute vec4 texture1_coordinates;
 attribute vec4 texture2_coordinates;
 
+#ifdef INSTANCING
+#ifdef INSTANCE_ARRAY_SIZE
+attribute float instance_index;
+
+uniform mat4 instance_model_matrices[INSTANCE_ARRAY_SIZE];
+uniform vec4 instance_colors[INSTANCE_ARRAY_SIZE];
+#else
+attribute vec4 instance_model_matrix_column0;
+attribute vec4 instance_model_matrix_column1;
+attribute vec4 instance_model_matrix_column2;
+attribute vec4 instance_model_matrix_column3;
+attribute vec4 instance_color;
+#endif
+
+uniform mat4 view_matrix;
+#else
 uniform mat4 model_view_matrix;
+uniform vec4 instance_color;
+#endif
+
 uniform mat4 projection_matrix;
 uniform vec4 emission_color;
 uniform float point_size;
@@ -25,9 +44,26 @@ varying vec2 fragment_texture2_coordinates;
 
 void main()
 {
+#ifdef INSTANCING
+#ifdef INSTANCE_ARRAY_SIZE
+    int instance_slot = int(instance_index);
+    mat4 model_view_matrix = view_matrix * instance_model_matrices[instance_slot];
+    vec4 instance_color = instance_colors[instance_slot];
+#else
+    mat4 model_view_matrix =
+        view_matrix *
+        mat4(
+            instance_model_matrix_column0,
+            instance_model_matrix_column1,
+            instance_model_matrix_column2,
+            instance_model_matrix_column3
+        );
+#endif
+#endif
+
     vec4 view_position = model_view_matrix * position;
     fragment_view_position = view_position;
-    fragment_color = color * emission_color;
+    fragment_color = color * instance_color * emission_color;
 
     if (texture1_enabled) {
         if (texture1_transformation_enabled) {
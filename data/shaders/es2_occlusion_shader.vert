@@ -0,0 +1,12 @@
+#version 120
+
+attribute vec4 position;
+
+uniform mat4 view_projection_matrix;
+uniform vec3 box_minimum;
+uniform vec3 box_maximum;
+
+void main()
+{
+    gl_Position = view_projection_matrix * vec4(mix(box_minimum, box_maximum, position.xyz), 1.0);
+}
@@ -6,9 +6,28 @@ attribute vec3 binormal;
 attribute vec4 texture1_coordinates;
 attribute vec4 texture2_coordinates;
 
+#ifdef INSTANCING
+#ifdef INSTANCE_ARRAY_SIZE
+attribute float instance_index;
+
+uniform mat4 instance_model_matrices[INSTANCE_ARRAY_SIZE];
+uniform vec4 instance_colors[INSTANCE_ARRAY_SIZE];
+#else
+attribute vec4 instance_model_matrix_column0;
+attribute vec4 instance_model_matrix_column1;
+attribute vec4 instance_model_matrix_column2;
+attribute vec4 instance_model_matrix_column3;
+attribute vec4 instance_color;
+#endif
+
+uniform mat4 view_matrix;
+#else
 uniform mat4 model_view_matrix;
-uniform mat4 projection_matrix;
 uniform mat3 normal_matrix;
+uniform vec4 instance_color;
+#endif
+
+uniform mat4 projection_matrix;
 uniform float point_size;
 
 uniform bool texture1_enabled;
@@ -30,6 +49,33 @@ varying mat3 fragment_view_tangent_binormal_normal;
 
 void main()
 {
+#ifdef INSTANCING
+#ifdef INSTANCE_ARRAY_SIZE
+    int instance_slot = int(instance_index);
+    mat4 model_view_matrix = view_matrix * instance_model_matrices[instance_slot];
+    vec4 instance_color = instance_colors[instance_slot];
+#else
+    mat4 model_view_matrix =
+        view_matrix *
+        mat4(
+            instance_model_matrix_column0,
+            instance_model_matrix_column1,
+            instance_model_matrix_column2,
+            instance_model_matrix_column3
+        );
+#endif
+    // Exact only for orthogonal axes; the renderer does not instance meshes with sheared world matrices.
+    vec3 normal_matrix_column0 = model_view_matrix[0].xyz;
+    vec3 normal_matrix_column1 = model_view_matrix[1].xyz;
+    vec3 normal_matrix_column2 = model_view_matrix[2].xyz;
+    mat3 normal_matrix =
+        mat3(
+            normal_matrix_column0 / dot(normal_matrix_column0, normal_matrix_column0),
+            normal_matrix_column1 / dot(normal_matrix_column1, normal_matrix_column1),
+            normal_matrix_column2 / dot(normal_matrix_column2, normal_matrix_column2)
+        );
+#endif
+
     vec4 view_position = model_view_matrix * position;
     fragment_view_position = view_position;
     fragment_view_direction = -view_position.xyz;
@@ -41,7 +87,7 @@ void main()
             fragment_view_normal
         );
 
-    fragment_color = color;
+    fragment_color = color * instance_color;
     if (texture1_enabled) {
         if (texture1_transformation_enabled) {
             vec4 transformed_texture1_coordinates = texture1_transformation_matrix * vec4(texture1_coordinates.st, 0.0, 1.0);
@@ -10,9 +10,11 @@
 #include "lights/point_light.h"
 #include "lights/spot_light.h"
 #include "geometries/vertex.h"
+#include "geometries/vertex_layout.h"
 #include "geometries/geometry.h"
 #include "geometries/es2_geometry.h"
 #include "geometries/geometry_generators.h"
+#include "geometries/geometry_optimizers.h"
 #include "textures/texture.h"
 #include "textures/es2_texture.h"
 #include "materials/material.h"
@@ -21,17 +23,29 @@
 #include "materials/phong_material.h"
 #include "materials/es2_phong_material.h"
 #include "scene/scene.h"
+#include "scene/bvh.h"
 #include "window/window.h"
 #include "window/es2_sdl_window.h"
+#if __has_include(<EGL/egl.h>)
+#include "window/es2_egl_window.h"
+#endif
+#include "renderer/es2_state.h"
 #include "renderer/shader.h"
 #include "renderer/es2_shader.h"
+#include "renderer/es2_shader_registry.h"
+#include "renderer/es2_static_batch.h"
+#include "renderer/es2_occlusion_culler.h"
+#include "renderer/frame_uniforms.h"
+#include "renderer/render_list.h"
 #include "renderer/renderer.h"
 #include "renderer/es2_renderer.h"
 #include "math/ray.h"
 #include "math/plane.h"
 #include "math/aabb.h"
 #include "math/sphere.h"
+#include "math/frustum.h"
 #include "utilities/utilities.h"
+#include "utilities/worker_pool.h"
 
 #include <imgui.h>
 
@@ -2,13 +2,20 @@
 #define ES2_GEOMETRY_HPP
 
 #include "geometries/geometry.h"
+#include "geometries/vertex_layout.h"
+#include "renderer/es2_state.h"
 
 #include <GL/glew.h>
 #define SDL_MAIN_HANDLED
 #include <SDL.h>
 
+#include <algorithm>
+#include <array>
 #include <string>
 #include <iostream>
+#include <vector>
+#include <limits>
+#include <cstdint>
 
 namespace asr
 {
@@ -23,184 +30,370 @@ namespace asr
 
         ~ES2Geometry() final
         {
-            if (_vertex_array_object != 0) {
+            for (size_t i = 0; i < _StreamingBufferCount; ++i) {
+                if (_vertex_array_objects[i] != 0) {
+                    ES2State::get_instance().on_vertex_array_deleted(_vertex_array_objects[i]);
 #ifdef __APPLE__
-                glDeleteVertexArraysAPPLE(1, &_vertex_array_object);
+                    glDeleteVertexArraysAPPLE(1, &_vertex_array_objects[i]);
 #else
-                glDeleteVertexArrays(1, &_vertex_array_object);
+                    glDeleteVertexArrays(1, &_vertex_array_objects[i]);
 #endif
+                }
+                if (_vertex_buffers[i].object != 0) {
+                    glDeleteBuffers(1, &_vertex_buffers[i].object);
+                }
+                if (_vertex_buffers[i].fence != nullptr) {
+                    glDeleteSync(_vertex_buffers[i].fence);
+                }
             }
 
-            if (_index_buffer_object != 0) {
-                glDeleteBuffers(1, &_index_buffer_object);
+            if (_index_buffer.object != 0) {
+                glDeleteBuffers(1, &_index_buffer.object);
             }
+        }
 
-            if (_vertex_buffer_object != 0) {
-                glDeleteBuffers(1, &_vertex_buffer_object);
-            }
+        [[nodiscard]] size_t get_uploaded_byte_count() const
+        {
+            return _uploaded_byte_count;
+        }
+
+        // Uploads that found the next streaming buffer still queued for drawing and orphaned it instead of waiting.
+        [[nodiscard]] size_t get_stall_count() const
+        {
+            return _stall_count;
         }
 
+        void reset_statistics()
+        {
+            _uploaded_byte_count = 0;
+            _stall_count = 0;
+        }
+
+        /* Buffers are created once and kept for the lifetime of the geometry. They are reallocated in place when their
+         * size or usage changes and otherwise only the dirty ranges are uploaded, so the vertex array objects, which
+         * refer to the buffers by name, are built a single time.
+         *
+         * Vertices with the stream or dynamic strategy rotate through a ring of buffers, each with its own vertex array
+         * object, so that writing the next frame's data does not wait for the GPU to finish reading the last one. */
         void update(const Material &material) final
         {
             if (!(_requires_indices_update || _requires_vertices_update)) {
                 return;
             }
 
+            auto &state = ES2State::get_instance();
+
+            if (_index_buffer.object == 0) {
+                glGenBuffers(1, &_index_buffer.object);
+                _sync_supported = GLEW_ARB_sync;
+                _half_float_supported = GLEW_ARB_half_float_vertex || GLEW_VERSION_3_0;
+            }
+
+            bool streaming{_vertices_usage_strategy != StaticStrategy};
+            if (_requires_vertices_update && streaming && _vertex_array_objects[0] != 0) {
+                _advance_vertex_buffer();
+            }
+
+            VertexLayout vertex_layout{
+                _half_float_supported ?
+                    _vertex_layout : _vertex_layout.replace_component_type(VertexLayout::HalfFloat, VertexLayout::Float)
+            };
+
+            auto &vertex_array_object = _vertex_array_objects[_vertex_buffer_index];
+            bool requires_vertex_array{vertex_array_object == 0};
+            if (!requires_vertex_array && _requires_vertices_update &&
+                _vertex_array_layouts[_vertex_buffer_index] != vertex_layout) {
+                state.on_vertex_array_deleted(vertex_array_object);
 #ifdef __APPLE__
-            glBindVertexArrayAPPLE(0);
+                glDeleteVertexArraysAPPLE(1, &vertex_array_object);
 #else
-            glBindVertexArray(0);
+                glDeleteVertexArrays(1, &vertex_array_object);
 #endif
-            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-            glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-            if (_vertex_array_object != 0) {
+                vertex_array_object = 0;
+                requires_vertex_array = true;
+            }
+            if (requires_vertex_array) {
 #ifdef __APPLE__
-                glDeleteVertexArraysAPPLE(1, &_vertex_array_object);
+                glGenVertexArraysAPPLE(1, &vertex_array_object);
 #else
-                glDeleteVertexArrays(1, &_vertex_array_object);
+                glGenVertexArrays(1, &vertex_array_object);
 #endif
+                if (_vertex_buffers[_vertex_buffer_index].object == 0) {
+                    glGenBuffers(1, &_vertex_buffers[_vertex_buffer_index].object);
+                }
             }
-            if (_index_buffer_object != 0) {
-                glDeleteBuffers(1, &_index_buffer_object);
-            }
-            if (_vertex_buffer_object != 0) {
-                glDeleteBuffers(1, &_vertex_buffer_object);
-            }
 
-            const auto *index_data = reinterpret_cast<const unsigned int *>(_indices.data());
-            const size_t index_data_size{_indices.size() * sizeof(unsigned int)};
+            auto &vertex_buffer = _vertex_buffers[_vertex_buffer_index];
+
+            // The element array binding is part of the vertex array state.
+            state.bind_vertex_array(vertex_array_object);
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _index_buffer.object);
+            glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer.object);
 
-            GLuint index_buffer_object{0};
-            glGenBuffers(1, &index_buffer_object);
-            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, index_buffer_object);
-            glBufferData(
-                GL_ELEMENT_ARRAY_BUFFER,
-                static_cast<GLsizeiptr>(index_data_size), index_data,
-                _convert_usage_strategy_to_es2_buffer_usage_strategy(_indices_usage_strategy)
-            );
-            _index_buffer_object = index_buffer_object;
+            if (_requires_indices_update) {
+                _upload_indices(_convert_usage_strategy_to_es2_buffer_usage_strategy(_indices_usage_strategy));
+                _clear_dirty_range(_dirty_indices_begin, _dirty_indices_end);
+                _requires_indices_update = false;
+            }
 
-            _requires_indices_update = false;
+            if (_requires_vertices_update) {
+                // Each buffer of the ring collects the ranges modified since it was last written and refills only those.
+                if (_dirty_vertices_begin < _dirty_vertices_end) {
+                    for (auto &buffer : _vertex_buffers) {
+                        _extend_dirty_range(
+                            buffer.dirty_begin, buffer.dirty_end, _dirty_vertices_begin, _dirty_vertices_end - _dirty_vertices_begin
+                        );
+                    }
+                }
+                _upload_vertices(
+                    vertex_layout, _convert_usage_strategy_to_es2_buffer_usage_strategy(_vertices_usage_strategy),
+                    vertex_buffer
+                );
+                _clear_dirty_range(vertex_buffer.dirty_begin, vertex_buffer.dirty_end);
+                _clear_dirty_range(_dirty_vertices_begin, _dirty_vertices_end);
+                _requires_vertices_update = false;
+            }
 
-            const auto *vertex_data = reinterpret_cast<const float *>(_vertices.data());
-            const size_t vertex_data_size{_vertices.size() * sizeof(Vertex)};
+            if (requires_vertex_array) {
+                const auto &shader = *material.get_shader();
+                set_vertex_attribute_pointers(shader, vertex_layout);
+                _vertex_array_layouts[_vertex_buffer_index] = vertex_layout;
 
-            GLuint vertex_buffer_object{0};
-            glGenBuffers(1, &vertex_buffer_object);
-            glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer_object);
-            glBufferData(
-                GL_ARRAY_BUFFER,
-                static_cast<GLsizeiptr>(vertex_data_size), vertex_data,
-                _convert_usage_strategy_to_es2_buffer_usage_strategy(_vertices_usage_strategy)
-            );
-            _vertex_buffer_object = vertex_buffer_object;
+                // Disabled arrays read the generic value, and vertices are white unless their layout says otherwise.
+                _generic_color_locations[_vertex_buffer_index] =
+                    vertex_layout.has(VertexLayout::Color) ? -1 : shader.get_attribute_location(shader.get_attribute("color"));
+            }
 
-            _requires_vertices_update = false;
+            state.bind_vertex_array(0);
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+        }
 
-            GLuint vertex_array_object{0};
-#ifdef __APPLE__
-            glGenVertexArraysAPPLE(1, &vertex_array_object);
-            glBindVertexArrayAPPLE(vertex_array_object);
-#else
-            glGenVertexArrays(1, &vertex_array_object);
-            glBindVertexArray(vertex_array_object);
-#endif
-            glBindBuffer(GL_ARRAY_BUFFER, _vertex_buffer_object);
-            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _index_buffer_object);
+        static void set_vertex_attribute_pointers(
+            const Shader &shader, const VertexLayout &vertex_layout = VertexLayout::get_default()
+        )
+        {
+            auto stride = static_cast<GLsizei>(vertex_layout.get_stride());
 
-            auto &attributes = material.get_shader()->get_attributes();
+            for (size_t i = 0; i < VertexLayout::AttributeCount; ++i) {
+                int attribute_location{shader.get_attribute_location(shader.get_attribute(_attribute_names[i]))};
+                if (attribute_location == -1) {
+                    continue;
+                }
 
-            GLsizei stride = sizeof(GLfloat) * 25;
+                const auto *element = vertex_layout.find(static_cast<VertexLayout::Attribute>(i));
+                if (element == nullptr) {
+                    glDisableVertexAttribArray(static_cast<GLuint>(attribute_location));
+                    continue;
+                }
 
-            int position_attribute_location{attributes.count("position") > 0 ? attributes.at("position") : -1};
-            if (position_attribute_location != -1) {
-                glEnableVertexAttribArray(static_cast<GLuint>(position_attribute_location));
+                glEnableVertexAttribArray(static_cast<GLuint>(attribute_location));
                 glVertexAttribPointer(
-                    static_cast<GLuint>(position_attribute_location),
-                    3, GL_FLOAT, GL_FALSE, stride, static_cast<const GLvoid *>(nullptr)
+                    static_cast<GLuint>(attribute_location),
+                    static_cast<GLint>(element->component_count),
+                    _convert_component_type_to_es2_type(element->component_type),
+                    _is_normalized(element->component_type) ? GL_TRUE : GL_FALSE,
+                    stride, reinterpret_cast<const GLvoid *>(element->offset)
                 );
             }
+        }
 
-            int color_attribute_location{attributes.count("color") > 0 ? attributes.at("color") : -1};
-            if (color_attribute_location != -1) {
-                glEnableVertexAttribArray(static_cast<GLuint>(color_attribute_location));
-                glVertexAttribPointer(
-                    static_cast<GLuint>(color_attribute_location),
-                    4, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<const GLvoid *>(sizeof(GLfloat) * 3)
-                );
+        void use() final
+        {
+            if (_vertex_array_objects[_vertex_buffer_index] != 0) {
+                ES2State::get_instance().bind_vertex_array(_vertex_array_objects[_vertex_buffer_index]);
+
+                int generic_color_location{_generic_color_locations[_vertex_buffer_index]};
+                if (generic_color_location != -1) {
+                    glVertexAttrib4f(static_cast<GLuint>(generic_color_location), 1.0f, 1.0f, 1.0f, 1.0f);
+                }
             }
+        }
 
-            int normal_attribute_location{attributes.count("normal") > 0 ? attributes.at("normal") : -1};
-            if (normal_attribute_location != -1) {
-                glEnableVertexAttribArray(static_cast<GLuint>(normal_attribute_location));
-                glVertexAttribPointer(
-                    static_cast<GLuint>(normal_attribute_location),
-                    3, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<const GLvoid *>(sizeof(GLfloat) * 7)
-                );
+    private:
+        struct Buffer
+        {
+            GLuint object{0};
+            size_t size{0};
+            GLenum usage{GL_NONE};
+            GLsync fence{nullptr};
+
+            // Vertices modified since the buffer was last written.
+            size_t dirty_begin{std::numeric_limits<size_t>::max()};
+            size_t dirty_end{0};
+        };
+
+        static constexpr size_t _StreamingBufferCount{3};
+
+        inline static const std::array<std::string, VertexLayout::AttributeCount> _attribute_names{
+            "position", "color", "normal", "tangent", "binormal", "texture1_coordinates", "texture2_coordinates"
+        };
+
+        std::array<GLuint, _StreamingBufferCount> _vertex_array_objects{};
+        std::array<VertexLayout, _StreamingBufferCount> _vertex_array_layouts{};
+        std::array<int, _StreamingBufferCount> _generic_color_locations{-1, -1, -1};
+        std::array<Buffer, _StreamingBufferCount> _vertex_buffers{};
+        size_t _vertex_buffer_index{0};
+        Buffer _index_buffer;
+        bool _sync_supported{false};
+        bool _half_float_supported{false};
+        std::vector<uint8_t> _packed_vertices;
+        std::vector<uint8_t> _packed_indices;
+
+        size_t _uploaded_byte_count{0};
+        size_t _stall_count{0};
+
+        void _advance_vertex_buffer()
+        {
+            // Every draw that read the current buffer has been issued by now.
+            auto &current_buffer = _vertex_buffers[_vertex_buffer_index];
+            if (_sync_supported) {
+                if (current_buffer.fence != nullptr) {
+                    glDeleteSync(current_buffer.fence);
+                }
+                current_buffer.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
             }
 
-            int tangent_attribute_location{attributes.count("tangent") > 0 ? attributes.at("tangent") : -1};
-            if (tangent_attribute_location != -1) {
-                glEnableVertexAttribArray(static_cast<GLuint>(tangent_attribute_location));
-                glVertexAttribPointer(
-                    static_cast<GLuint>(tangent_attribute_location),
-                    4, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<const GLvoid *>(sizeof(GLfloat) * 10)
-                );
+            _vertex_buffer_index = (_vertex_buffer_index + 1) % _StreamingBufferCount;
+
+            auto &next_buffer = _vertex_buffers[_vertex_buffer_index];
+            if (next_buffer.object == 0) {
+                return;
             }
 
-            int binormal_attribute_location{attributes.count("binormal") > 0 ? attributes.at("binormal") : -1};
-            if (binormal_attribute_location != -1) {
-                glEnableVertexAttribArray(static_cast<GLuint>(binormal_attribute_location));
-                glVertexAttribPointer(
-                    static_cast<GLuint>(binormal_attribute_location),
-                    3, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<const GLvoid *>(sizeof(GLfloat) * 14)
-                );
+            bool busy{true};
+            if (next_buffer.fence != nullptr) {
+                GLenum status = glClientWaitSync(next_buffer.fence, 0, 0);
+                busy = status == GL_TIMEOUT_EXPIRED;
+                glDeleteSync(next_buffer.fence);
+                next_buffer.fence = nullptr;
+                if (busy) {
+                    ++_stall_count;
+                }
             }
 
-            int texture1_coordinates_attribute_location{attributes.count("texture1_coordinates") > 0 ? attributes.at("texture1_coordinates") : -1};
-            if (texture1_coordinates_attribute_location != -1) {
-                glEnableVertexAttribArray(static_cast<GLuint>(texture1_coordinates_attribute_location));
-                glVertexAttribPointer(
-                    static_cast<GLuint>(texture1_coordinates_attribute_location),
-                    4, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<const GLvoid *>(sizeof(GLfloat) * 17)
-                );
+            // Without fences there is no way to tell, so the buffer is always orphaned.
+            if (busy) {
+                next_buffer.size = 0;
             }
+        }
 
-            int texture2_coordinates_attribute_location{attributes.count("texture2_coordinates") > 0 ? attributes.at("texture2_coordinates") : -1};
-            if (texture2_coordinates_attribute_location != -1) {
-                glEnableVertexAttribArray(static_cast<GLuint>(texture2_coordinates_attribute_location));
-                glVertexAttribPointer(
-                    static_cast<GLuint>(texture2_coordinates_attribute_location),
-                    4, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<const GLvoid *>(sizeof(GLfloat) * 21)
+        void _upload_vertices(const VertexLayout &vertex_layout, GLenum usage, Buffer &buffer)
+        {
+            size_t stride{vertex_layout.get_stride()};
+            size_t data_size{_vertices.size() * stride};
+            bool reallocate{data_size != buffer.size || usage != buffer.usage};
+
+            size_t begin{reallocate ? 0 : buffer.dirty_begin};
+            size_t end{reallocate ? _vertices.size() : std::min(buffer.dirty_end, _vertices.size())};
+            if (!reallocate && begin >= end) {
+                return;
+            }
+
+            const uint8_t *data;
+            if (vertex_layout == VertexLayout::get_default()) {
+                data = reinterpret_cast<const uint8_t *>(_vertices.data() + begin);
+            } else {
+                _packed_vertices.resize((end - begin) * stride);
+                vertex_layout.pack(_vertices, begin, end, _packed_vertices.data());
+                data = _packed_vertices.data();
+            }
+
+            if (reallocate) {
+                glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(data_size), data, usage);
+                buffer.size = data_size;
+                buffer.usage = usage;
+            } else {
+                glBufferSubData(
+                    GL_ARRAY_BUFFER,
+                    static_cast<GLintptr>(begin * stride), static_cast<GLsizeiptr>((end - begin) * stride), data
                 );
             }
-#ifdef __APPLE__
-                glBindVertexArrayAPPLE(0);
-#else
-            glBindVertexArray(0);
-#endif
-            glBindBuffer(GL_ARRAY_BUFFER, 0);
-            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+            _uploaded_byte_count += (end - begin) * stride;
+        }
+
+        void _upload_indices(GLenum usage)
+        {
+            size_t count{_indices.size()};
+            size_t begin{std::min(_dirty_indices_begin, count)};
+            size_t end{std::min(_dirty_indices_end, count)};
+
+            unsigned int maximum_index{0};
+            for (size_t i = begin; i < end; ++i) {
+                maximum_index = std::max(maximum_index, _indices[i]);
+            }
 
-            _vertex_array_object = vertex_array_object;
+            // Partial updates can only widen the type since the rest of the indices were not looked at.
+            IndexType index_type{get_smallest_index_type(maximum_index, _byte_indices_enabled)};
+            if (begin > 0 || end < count) {
+                index_type = std::max(index_type, _index_type);
+            }
+
+            size_t index_size{get_index_size(index_type)};
+            size_t data_size{count * index_size};
+            bool reallocate{data_size != _index_buffer.size || usage != _index_buffer.usage || index_type != _index_type};
+            if (reallocate) {
+                begin = 0;
+                end = count;
+            } else if (begin >= end) {
+                return;
+            }
+            _index_type = index_type;
+
+            const uint8_t *data;
+            if (index_type == UnsignedIntIndices) {
+                data = reinterpret_cast<const uint8_t *>(_indices.data() + begin);
+            } else {
+                _packed_indices.resize((end - begin) * index_size);
+                if (index_type == UnsignedShortIndices) {
+                    auto *packed_indices = reinterpret_cast<uint16_t *>(_packed_indices.data());
+                    for (size_t i = begin; i < end; ++i) {
+                        packed_indices[i - begin] = static_cast<uint16_t>(_indices[i]);
+                    }
+                } else {
+                    for (size_t i = begin; i < end; ++i) {
+                        _packed_indices[i - begin] = static_cast<uint8_t>(_indices[i]);
+                    }
+                }
+                data = _packed_indices.data();
+            }
+
+            if (reallocate) {
+                glBufferData(GL_ELEMENT_ARRAY_BUFFER, static_cast<GLsizeiptr>(data_size), data, usage);
+                _index_buffer.size = data_size;
+                _index_buffer.usage = usage;
+            } else {
+                glBufferSubData(
+                    GL_ELEMENT_ARRAY_BUFFER,
+                    static_cast<GLintptr>(begin * index_size), static_cast<GLsizeiptr>((end - begin) * index_size), data
+                );
+            }
+            _uploaded_byte_count += (end - begin) * index_size;
         }
 
-        void use() final
+        static GLenum _convert_component_type_to_es2_type(VertexLayout::ComponentType component_type)
         {
-            if (_vertex_array_object != 0) {
-#ifdef __APPLE__
-                glBindVertexArrayAPPLE(_vertex_array_object);
-#else
-                glBindVertexArray(_vertex_array_object);
-#endif
+            switch (component_type) {
+                case VertexLayout::Float:
+                    return GL_FLOAT;
+                case VertexLayout::HalfFloat:
+                    return GL_HALF_FLOAT;
+                case VertexLayout::NormalizedByte:
+                    return GL_BYTE;
+                case VertexLayout::NormalizedUnsignedByte:
+                    return GL_UNSIGNED_BYTE;
+                case VertexLayout::NormalizedShort:
+                    return GL_SHORT;
+                case VertexLayout::NormalizedUnsignedShort:
+                    return GL_UNSIGNED_SHORT;
             }
+            return GL_FLOAT;
         }
 
-    private:
-        GLuint _vertex_array_object{0};
-        GLuint _index_buffer_object{0};
-        GLuint _vertex_buffer_object{0};
+        static bool _is_normalized(VertexLayout::ComponentType component_type)
+        {
+            return component_type != VertexLayout::Float && component_type != VertexLayout::HalfFloat;
+        }
 
         static GLenum _convert_usage_strategy_to_es2_buffer_usage_strategy(Geometry::UsageStrategy usage_strategy)
         {
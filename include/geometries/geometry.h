@@ -3,11 +3,22 @@
 
 #include "materials/material.h"
 #include "geometries/vertex.h"
-
+#include "geometries/vertex_layout.h"
+#include "geometries/geometry_optimizers.h"
+#include "math/aabb.h"
+#include "math/sphere.h"
+
+#include <algorithm>
+#include <limits>
+#include <memory>
 #include <vector>
 #include <utility>
+#include <cstddef>
+#include <cstdint>
+#include <cmath>
 
 #include <glm/glm.hpp>
+#include <glm/gtc/matrix_inverse.hpp>
 
 namespace asr
 {
@@ -32,6 +43,24 @@ namespace asr
             StreamStrategy
         };
 
+        // Ordered from the smallest to the largest type.
+        enum IndexType
+        {
+            UnsignedByteIndices,
+            UnsignedShortIndices,
+            UnsignedIntIndices
+        };
+
+        /* Told when vertices are edited while the bounds are current, so spatial structures can refit the meshes using
+         * the geometry without polling it. Further edits before the bounds are recomputed are not reported again. */
+        class BoundsListener
+        {
+        public:
+            virtual ~BoundsListener() = default;
+
+            virtual void on_geometry_bounds_changed(Geometry &geometry) = 0;
+        };
+
         explicit Geometry(std::vector<unsigned int> indices, std::vector<Vertex> vertices)
                 : _indices(std::move(indices)), _vertices(std::move(vertices))
         {}
@@ -45,7 +74,10 @@ namespace asr
 
         void set_type(Type type)
         {
-            _type = type;
+            if (_type != type) {
+                _type = type;
+                ++_version;
+            }
         }
 
         [[nodiscard]] const std::vector<unsigned int> &get_indices() const
@@ -61,7 +93,7 @@ namespace asr
         void set_indices(const std::vector<unsigned int> &indices)
         {
             _indices = indices;
-            _requires_indices_update = true;
+            _mark_all_indices_dirty();
         }
 
         [[nodiscard]] const std::vector<Vertex> &get_vertices() const
@@ -77,17 +109,101 @@ namespace asr
         void set_vertices(const std::vector<Vertex> &vertices)
         {
             _vertices = vertices;
-            _requires_vertices_update = true;
+            _mark_all_vertices_dirty();
         }
 
         void set_requires_indices_update(bool requires_indices_update)
         {
-            _requires_indices_update = requires_indices_update;
+            if (requires_indices_update) {
+                _mark_all_indices_dirty();
+            } else {
+                _requires_indices_update = false;
+                _clear_dirty_range(_dirty_indices_begin, _dirty_indices_end);
+            }
         }
 
         void set_requires_vertices_update(bool requires_vertices_update)
         {
-            _requires_vertices_update = requires_vertices_update;
+            if (requires_vertices_update) {
+                _mark_all_vertices_dirty();
+            } else {
+                _requires_vertices_update = false;
+                _clear_dirty_range(_dirty_vertices_begin, _dirty_vertices_end);
+            }
+        }
+
+        // Only the union of the ranges marked since the last update is uploaded, so edits made in place through
+        // get_indices() or get_vertices() should be reported here rather than with set_requires_*_update.
+        void mark_indices_dirty(size_t first, size_t count)
+        {
+            _extend_dirty_range(_dirty_indices_begin, _dirty_indices_end, first, count);
+            _requires_indices_update = true;
+            ++_version;
+        }
+
+        void mark_vertices_dirty(size_t first, size_t count)
+        {
+            _extend_dirty_range(_dirty_vertices_begin, _dirty_vertices_end, first, count);
+            _requires_vertices_update = true;
+            ++_version;
+            if (!_requires_bounds_update) {
+                _requires_bounds_update = true;
+                _notify_bounds_listeners();
+            }
+        }
+
+        // Changes whenever the type, indices, vertices or vertex layout are modified, for consumers that keep copies.
+        [[nodiscard]] size_t get_version() const
+        {
+            return _version;
+        }
+
+        [[nodiscard]] const VertexLayout &get_vertex_layout() const
+        {
+            return _vertex_layout;
+        }
+
+        void set_vertex_layout(const VertexLayout &vertex_layout)
+        {
+            if (_vertex_layout != vertex_layout) {
+                _vertex_layout = vertex_layout;
+                _mark_all_vertices_dirty();
+            }
+        }
+
+        const AABB &get_bounding_box()
+        {
+            _update_bounds_if_necessary();
+
+            return _bounding_box;
+        }
+
+        const Sphere &get_bounding_sphere()
+        {
+            _update_bounds_if_necessary();
+
+            return _bounding_sphere;
+        }
+
+        [[nodiscard]] size_t get_bounds_version() const
+        {
+            return _bounds_version;
+        }
+
+        void add_bounds_listener(const std::shared_ptr<BoundsListener> &bounds_listener)
+        {
+            _bounds_listeners.push_back(bounds_listener);
+        }
+
+        void remove_bounds_listener(const BoundsListener *bounds_listener)
+        {
+            _bounds_listeners.erase(
+                std::remove_if(std::begin(_bounds_listeners), std::end(_bounds_listeners), [&](const auto &listener) {
+                    auto locked_listener = listener.lock();
+                    return !locked_listener || locked_listener.get() == bounds_listener;
+                }),
+                std::end(_bounds_listeners)
+            );
         }
 
         [[nodiscard]] UsageStrategy get_vertices_usage_strategy() const
@@ -99,7 +215,7 @@ namespace asr
         {
             if (_vertices_usage_strategy != vertices_usage_strategy) {
                 _vertices_usage_strategy = vertices_usage_strategy;
-                _requires_vertices_update = true;
+                _mark_all_vertices_dirty();
             }
         }
 
@@ -112,10 +228,55 @@ namespace asr
         {
             if (_indices_usage_strategy != indices_usage_strategy) {
                 _indices_usage_strategy = indices_usage_strategy;
-                _requires_indices_update = true;
+                _mark_all_indices_dirty();
+            }
+        }
+
+        // The type used for the uploaded indices, the smallest one that can hold the largest index.
+        [[nodiscard]] IndexType get_index_type() const
+        {
+            return _index_type;
+        }
+
+        [[nodiscard]] bool is_byte_indices_enabled() const
+        {
+            return _byte_indices_enabled;
+        }
+
+        // Byte indices are converted on the CPU by many desktop drivers, so they have to be asked for explicitly.
+        void set_byte_indices_enabled(bool byte_indices_enabled)
+        {
+            if (_byte_indices_enabled != byte_indices_enabled) {
+                _byte_indices_enabled = byte_indices_enabled;
+                _mark_all_indices_dirty();
             }
         }
 
+        static size_t get_index_size(IndexType index_type)
+        {
+            switch (index_type) {
+                case UnsignedByteIndices:
+                    return 1;
+                case UnsignedShortIndices:
+                    return 2;
+                case UnsignedIntIndices:
+                    return 4;
+            }
+
+            return 4;
+        }
+
+        static IndexType get_smallest_index_type(unsigned int maximum_index, bool byte_indices_enabled = false)
+        {
+            if (byte_indices_enabled && maximum_index <= std::numeric_limits<uint8_t>::max()) {
+                return UnsignedByteIndices;
+            } else if (maximum_index <= std::numeric_limits<uint16_t>::max()) {
+                return UnsignedShortIndices;
+            }
+
+            return UnsignedIntIndices;
+        }
+
         [[nodiscard]] float get_line_width() const
         {
             return _line_width;
@@ -128,10 +289,21 @@ namespace asr
 
         void transform(glm::mat4 transformation_matrix)
         {
-            for (auto &vertex : _vertices) {
+            transform_vertices(_vertices, transformation_matrix);
+            _mark_all_vertices_dirty();
+        }
+
+        static void transform_vertices(std::vector<Vertex> &vertices, const glm::mat4 &transformation_matrix)
+        {
+            glm::mat3 direction_matrix{transformation_matrix};
+            glm::mat3 normal_matrix{glm::inverseTranspose(direction_matrix)};
+
+            for (auto &vertex : vertices) {
                 vertex.position = glm::vec3(transformation_matrix * glm::vec4(vertex.position, 1.0f));
+                vertex.normal = _normalize_if_possible(normal_matrix * vertex.normal);
+                vertex.tangent = glm::vec4(_normalize_if_possible(direction_matrix * glm::vec3(vertex.tangent)), vertex.tangent.w);
+                vertex.binormal = _normalize_if_possible(direction_matrix * vertex.binormal);
             }
-            _requires_vertices_update = true;
         }
 
         void calculate_tangents_and_binormals()
@@ -214,7 +386,26 @@ namespace asr
                 vertex.binormal = glm::cross(normal, tangent) * tangent_with_determinant[3];
             }
 
-            _requires_vertices_update = true;
+            _mark_all_vertices_dirty();
+        }
+
+        /* Reorders the triangles for the post-transform vertex cache and for less overdraw, merges identical vertices
+         * and lays the vertices out in the order they are fetched. Meant to be run once when a mesh is loaded. Only
+         * triangle lists are handled; other types are left untouched and get empty statistics. */
+        geometry_optimizers::OptimizationStatistics optimize(
+            size_t cache_size = geometry_optimizers::DefaultVertexCacheSize,
+            float overdraw_threshold = geometry_optimizers::DefaultOverdrawThreshold
+        )
+        {
+            if (_type != Triangles) {
+                return geometry_optimizers::OptimizationStatistics{};
+            }
+
+            auto statistics = geometry_optimizers::optimize(_indices, _vertices, cache_size, overdraw_threshold);
+            _mark_all_indices_dirty();
+            _mark_all_vertices_dirty();
+
+            return statistics;
         }
 
         virtual void update(const Material &material) = 0;
@@ -226,13 +417,101 @@ namespace asr
 
         std::vector<unsigned int> _indices;
         bool _requires_indices_update{true};
+        IndexType _index_type{UnsignedIntIndices};
+        bool _byte_indices_enabled{false};
+        size_t _dirty_indices_begin{0};
+        size_t _dirty_indices_end{std::numeric_limits<size_t>::max()};
         std::vector<Vertex> _vertices;
         bool _requires_vertices_update{true};
+        size_t _dirty_vertices_begin{0};
+        size_t _dirty_vertices_end{std::numeric_limits<size_t>::max()};
+        VertexLayout _vertex_layout{VertexLayout::get_default()};
 
         UsageStrategy _vertices_usage_strategy{StaticStrategy};
         UsageStrategy _indices_usage_strategy{StaticStrategy};
 
         float _line_width{1.0f};
+
+        size_t _version{0};
+
+        bool _requires_bounds_update{true};
+        size_t _bounds_version{0};
+        AABB _bounding_box{glm::vec3{0.0f}, glm::vec3{0.0f}};
+        Sphere _bounding_sphere{glm::vec3{0.0f}, 0.0f};
+        std::vector<std::weak_ptr<BoundsListener>> _bounds_listeners;
+
+        static glm::vec3 _normalize_if_possible(const glm::vec3 &vector)
+        {
+            float length = glm::length(vector);
+
+            return length > 0.0f ? vector / length : vector;
+        }
+
+        static void _extend_dirty_range(size_t &begin, size_t &end, size_t first, size_t count)
+        {
+            if (count == 0) {
+                return;
+            }
+
+            begin = std::min(begin, first);
+            end = std::max(end, count > std::numeric_limits<size_t>::max() - first ? std::numeric_limits<size_t>::max() : first + count);
+        }
+
+        static void _clear_dirty_range(size_t &begin, size_t &end)
+        {
+            begin = std::numeric_limits<size_t>::max();
+            end = 0;
+        }
+
+        void _mark_all_indices_dirty()
+        {
+            mark_indices_dirty(0, std::numeric_limits<size_t>::max());
+        }
+
+        void _mark_all_vertices_dirty()
+        {
+            mark_vertices_dirty(0, std::numeric_limits<size_t>::max());
+        }
+
+        void _notify_bounds_listeners()
+        {
+            for (const auto &listener : _bounds_listeners) {
+                if (auto bounds_listener = listener.lock()) {
+                    bounds_listener->on_geometry_bounds_changed(*this);
+                }
+            }
+        }
+
+        void _update_bounds_if_necessary()
+        {
+            if (!_requires_bounds_update) {
+                return;
+            }
+
+            glm::vec3 minimum{0.0f}, maximum{0.0f};
+            if (!_vertices.empty()) {
+                minimum = glm::vec3{INFINITY};
+                maximum = glm::vec3{-INFINITY};
+                for (const auto &vertex : _vertices) {
+                    minimum = glm::min(minimum, vertex.position);
+                    maximum = glm::max(maximum, vertex.position);
+                }
+            }
+            _bounding_box.set_minimum(minimum);
+            _bounding_box.set_maximum(maximum);
+
+            glm::vec3 center = (minimum + maximum) * 0.5f;
+            float squared_radius{0.0f};
+            for (const auto &vertex : _vertices) {
+                glm::vec3 offset = vertex.position - center;
+                squared_radius = fmaxf(squared_radius, glm::dot(offset, offset));
+            }
+            _bounding_sphere.set_center(center);
+            _bounding_sphere.set_radius(sqrtf(squared_radius));
+
+            ++_bounds_version;
+            _requires_bounds_update = false;
+        }
     };
 }
 
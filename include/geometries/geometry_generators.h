@@ -389,6 +389,73 @@ namespace asr::geometry_generators
 
         return std::make_pair(indices, vertices);
     }
+
+    /* LOD chains are ordered from the finest level to the coarsest, halving the segment counts at every level. */
+    static unsigned int get_level_segment_count(unsigned int segment_count, unsigned int level, unsigned int minimum_segment_count)
+    {
+        unsigned int level_segment_count{level < 32 ? segment_count >> level : 0};
+
+        return level_segment_count > minimum_segment_count ? level_segment_count : minimum_segment_count;
+    }
+
+    static std::vector<geometry_data_type> generate_rectangle_lod_geometry_data(
+                                               float width, float height,
+                                               unsigned int width_segments_count,
+                                               unsigned int height_segments_count,
+                                               unsigned int level_count
+                                           )
+    {
+        std::vector<geometry_data_type> levels;
+        for (unsigned int level = 0; level < level_count; ++level) {
+            levels.push_back(generate_rectangle_geometry_data(
+                width, height,
+                get_level_segment_count(width_segments_count, level, 1),
+                get_level_segment_count(height_segments_count, level, 1)
+            ));
+        }
+
+        return levels;
+    }
+
+    static std::vector<geometry_data_type> generate_box_lod_geometry_data(
+                                               float width, float height, float depth,
+                                               unsigned int width_segments_count,
+                                               unsigned int height_segments_count,
+                                               unsigned int depth_segments_count,
+                                               unsigned int level_count
+                                           )
+    {
+        std::vector<geometry_data_type> levels;
+        for (unsigned int level = 0; level < level_count; ++level) {
+            levels.push_back(generate_box_geometry_data(
+                width, height, depth,
+                get_level_segment_count(width_segments_count, level, 1),
+                get_level_segment_count(height_segments_count, level, 1),
+                get_level_segment_count(depth_segments_count, level, 1)
+            ));
+        }
+
+        return levels;
+    }
+
+    static std::vector<geometry_data_type> generate_sphere_lod_geometry_data(
+                                               float radius,
+                                               unsigned int segment_count,
+                                               unsigned int ring_count,
+                                               unsigned int level_count
+                                           )
+    {
+        std::vector<geometry_data_type> levels;
+        for (unsigned int level = 0; level < level_count; ++level) {
+            levels.push_back(generate_sphere_geometry_data(
+                radius,
+                get_level_segment_count(segment_count, level, 3),
+                get_level_segment_count(ring_count, level, 2)
+            ));
+        }
+
+        return levels;
+    }
 }
 
 #endif
@@ -0,0 +1,396 @@
+#ifndef GEOMETRY_OPTIMIZERS_H
+#define GEOMETRY_OPTIMIZERS_H
+
+#include "geometries/vertex.h"
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <glm/glm.hpp>
+
+namespace asr::geometry_optimizers
+{
+    /* Reordering passes for indexed triangle lists. The post-transform cache is modelled as a FIFO, which is what
+     * older and mobile GPUs implement and a reasonable estimate for the batch-based schemes of newer ones. */
+
+    constexpr size_t DefaultVertexCacheSize{16};
+    constexpr float DefaultOverdrawThreshold{1.05f};
+
+    // ACMR is the number of transformed vertices per triangle, ATVR the number per referenced vertex. Both are at
+    // least one for a perfect order, and ACMR has a lower bound of about 0.5 for regular grids.
+    struct VertexCacheStatistics
+    {
+        float acmr{0.0f};
+        float atvr{0.0f};
+    };
+
+    struct OptimizationStatistics
+    {
+        VertexCacheStatistics before;
+        VertexCacheStatistics after;
+    };
+
+    // A vertex is in the cache when fewer than cache_size misses happened since it was last loaded.
+    static size_t _simulate_vertex_cache(
+        const unsigned int *indices, size_t index_count,
+        std::vector<size_t> &timestamps, size_t &timestamp, size_t cache_size
+    )
+    {
+        size_t miss_count{0};
+        for (size_t i = 0; i < index_count; ++i) {
+            unsigned int index{indices[i]};
+            if (timestamp - timestamps[index] > cache_size) {
+                timestamps[index] = timestamp++;
+                ++miss_count;
+            }
+        }
+
+        return miss_count;
+    }
+
+    static VertexCacheStatistics analyze_vertex_cache(
+        const std::vector<unsigned int> &indices, size_t vertex_count, size_t cache_size = DefaultVertexCacheSize
+    )
+    {
+        VertexCacheStatistics statistics;
+
+        size_t triangle_count{indices.size() / 3};
+        if (triangle_count == 0) {
+            return statistics;
+        }
+
+        std::vector<size_t> timestamps(vertex_count, 0);
+        size_t timestamp{cache_size + 1};
+        size_t miss_count{_simulate_vertex_cache(indices.data(), triangle_count * 3, timestamps, timestamp, cache_size)};
+
+        std::vector<bool> referenced(vertex_count, false);
+        for (auto index : indices) {
+            referenced[index] = true;
+        }
+        auto referenced_vertex_count = static_cast<size_t>(std::count(std::begin(referenced), std::end(referenced), true));
+
+        statistics.acmr = static_cast<float>(miss_count) / static_cast<float>(triangle_count);
+        statistics.atvr = static_cast<float>(miss_count) / static_cast<float>(referenced_vertex_count);
+
+        return statistics;
+    }
+
+    // Merges vertices with identical attributes. Unreferenced vertices are left for optimize_vertex_fetch to remove.
+    static void deduplicate_vertices(std::vector<unsigned int> &indices, std::vector<Vertex> &vertices)
+    {
+        struct VertexHash
+        {
+            size_t operator()(const Vertex *vertex) const
+            {
+                const auto *bytes = reinterpret_cast<const uint8_t *>(vertex);
+                uint64_t hash{14695981039346656037ull};
+                for (size_t i = 0; i < sizeof(Vertex); ++i) {
+                    hash = (hash ^ bytes[i]) * 1099511628211ull;
+                }
+
+                return static_cast<size_t>(hash);
+            }
+        };
+
+        struct VertexEqual
+        {
+            bool operator()(const Vertex *a, const Vertex *b) const
+            {
+                return std::memcmp(a, b, sizeof(Vertex)) == 0;
+            }
+        };
+
+        std::unordered_map<const Vertex *, unsigned int, VertexHash, VertexEqual> unique_indices;
+        unique_indices.reserve(vertices.size());
+
+        std::vector<unsigned int> remap(vertices.size());
+        std::vector<Vertex> unique_vertices;
+        unique_vertices.reserve(vertices.size());
+        for (size_t i = 0; i < vertices.size(); ++i) {
+            auto entry = unique_indices.emplace(&vertices[i], static_cast<unsigned int>(unique_vertices.size()));
+            if (entry.second) {
+                unique_vertices.push_back(vertices[i]);
+            }
+            remap[i] = entry.first->second;
+        }
+
+        for (auto &index : indices) {
+            index = remap[index];
+        }
+        vertices.swap(unique_vertices);
+    }
+
+    static void remove_degenerate_triangles(std::vector<unsigned int> &indices)
+    {
+        size_t index_count{0};
+        for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+            unsigned int a{indices[i]}, b{indices[i + 1]}, c{indices[i + 2]};
+            if (a != b && b != c && c != a) {
+                indices[index_count++] = a;
+                indices[index_count++] = b;
+                indices[index_count++] = c;
+            }
+        }
+        indices.resize(index_count);
+    }
+
+    /* Tipsify (Sander, Nehab and Barczak, "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw", 2007).
+     * Triangles are emitted as fans around a vertex, and the next fan is chosen among the vertices just emitted by
+     * how long they would stay in the cache. When none qualifies the search restarts elsewhere, which starts a new
+     * cluster; cluster start triangles are appended to clusters when it is given. */
+    static std::vector<unsigned int> optimize_vertex_cache(
+        const std::vector<unsigned int> &indices, size_t vertex_count,
+        size_t cache_size = DefaultVertexCacheSize, std::vector<size_t> *clusters = nullptr
+    )
+    {
+        size_t triangle_count{indices.size() / 3};
+
+        std::vector<unsigned int> live_triangle_counts(vertex_count, 0);
+        for (size_t i = 0; i < triangle_count * 3; ++i) {
+            ++live_triangle_counts[indices[i]];
+        }
+
+        std::vector<size_t> adjacency_offsets(vertex_count + 1, 0);
+        for (size_t i = 0; i < vertex_count; ++i) {
+            adjacency_offsets[i + 1] = adjacency_offsets[i] + live_triangle_counts[i];
+        }
+        std::vector<unsigned int> adjacency(triangle_count * 3);
+        std::vector<size_t> adjacency_cursors(std::begin(adjacency_offsets), std::end(adjacency_offsets) - 1);
+        for (size_t i = 0; i < triangle_count * 3; ++i) {
+            adjacency[adjacency_cursors[indices[i]]++] = static_cast<unsigned int>(i / 3);
+        }
+
+        std::vector<size_t> timestamps(vertex_count, 0);
+        size_t timestamp{cache_size + 1};
+        std::vector<bool> emitted(triangle_count, false);
+        std::vector<unsigned int> dead_ends;
+        dead_ends.reserve(triangle_count * 3);
+        std::vector<unsigned int> candidates;
+        size_t scan_cursor{0};
+
+        const auto skip_dead_end = [&]() -> int64_t {
+            while (!dead_ends.empty()) {
+                unsigned int vertex{dead_ends.back()};
+                dead_ends.pop_back();
+                if (live_triangle_counts[vertex] > 0) {
+                    return vertex;
+                }
+            }
+            for (; scan_cursor < vertex_count; ++scan_cursor) {
+                if (live_triangle_counts[scan_cursor] > 0) {
+                    return static_cast<int64_t>(scan_cursor);
+                }
+            }
+
+            return -1;
+        };
+
+        std::vector<unsigned int> result;
+        result.reserve(triangle_count * 3);
+
+        int64_t fanning_vertex{skip_dead_end()};
+        if (clusters != nullptr && fanning_vertex >= 0) {
+            clusters->push_back(0);
+        }
+        while (fanning_vertex >= 0) {
+            candidates.clear();
+
+            auto vertex = static_cast<size_t>(fanning_vertex);
+            for (size_t i = adjacency_offsets[vertex]; i < adjacency_offsets[vertex + 1]; ++i) {
+                unsigned int triangle{adjacency[i]};
+                if (emitted[triangle]) {
+                    continue;
+                }
+
+                for (size_t j = 0; j < 3; ++j) {
+                    unsigned int index{indices[triangle * 3 + j]};
+                    result.push_back(index);
+                    dead_ends.push_back(index);
+                    candidates.push_back(index);
+                    --live_triangle_counts[index];
+                    if (timestamp - timestamps[index] > cache_size) {
+                        timestamps[index] = timestamp++;
+                    }
+                }
+                emitted[triangle] = true;
+            }
+
+            int64_t next_vertex{-1};
+            int64_t best_priority{-1};
+            for (auto candidate : candidates) {
+                if (live_triangle_counts[candidate] == 0) {
+                    continue;
+                }
+
+                // Candidates that would be evicted before their remaining triangles are emitted get the lowest priority.
+                int64_t priority{0};
+                size_t age{timestamp - timestamps[candidate]};
+                if (age + 2 * live_triangle_counts[candidate] <= cache_size) {
+                    priority = static_cast<int64_t>(age);
+                }
+                if (priority > best_priority) {
+                    best_priority = priority;
+                    next_vertex = candidate;
+                }
+            }
+
+            if (next_vertex == -1) {
+                next_vertex = skip_dead_end();
+                if (clusters != nullptr && next_vertex >= 0) {
+                    clusters->push_back(result.size() / 3);
+                }
+            }
+            fanning_vertex = next_vertex;
+        }
+
+        return result;
+    }
+
+    /* Splits the clusters from optimize_vertex_cache further wherever the running ACMR of a cluster drops below the
+     * threshold times the ACMR of the whole cluster, then sorts them so that the ones facing away from the center
+     * of the mesh come first. Those tend to occlude the others from most directions. */
+    static void optimize_overdraw(
+        std::vector<unsigned int> &indices, const std::vector<Vertex> &vertices, const std::vector<size_t> &clusters,
+        size_t cache_size = DefaultVertexCacheSize, float threshold = DefaultOverdrawThreshold
+    )
+    {
+        size_t triangle_count{indices.size() / 3};
+        if (triangle_count == 0 || clusters.empty()) {
+            return;
+        }
+
+        std::vector<size_t> timestamps(vertices.size(), 0);
+        size_t timestamp{cache_size + 1};
+
+        std::vector<size_t> cluster_starts;
+        for (size_t i = 0; i < clusters.size(); ++i) {
+            size_t begin{clusters[i]};
+            size_t end{i + 1 < clusters.size() ? clusters[i + 1] : triangle_count};
+
+            timestamp += cache_size + 1;
+            size_t cluster_miss_count{
+                _simulate_vertex_cache(indices.data() + begin * 3, (end - begin) * 3, timestamps, timestamp, cache_size)
+            };
+            float cluster_threshold{threshold * static_cast<float>(cluster_miss_count) / static_cast<float>(end - begin)};
+
+            timestamp += cache_size + 1;
+            size_t start{begin};
+            size_t miss_count{0};
+            for (size_t triangle = begin; triangle < end; ++triangle) {
+                miss_count += _simulate_vertex_cache(indices.data() + triangle * 3, 3, timestamps, timestamp, cache_size);
+                if (static_cast<float>(miss_count) / static_cast<float>(triangle + 1 - start) <= cluster_threshold) {
+                    cluster_starts.push_back(start);
+                    start = triangle + 1;
+                    miss_count = 0;
+                    timestamp += cache_size + 1;
+                }
+            }
+            if (start < end) {
+                cluster_starts.push_back(start);
+            }
+        }
+
+        size_t cluster_count{cluster_starts.size()};
+        std::vector<glm::vec3> cluster_centroids(cluster_count, glm::vec3{0.0f});
+        std::vector<glm::vec3> cluster_normals(cluster_count, glm::vec3{0.0f});
+        std::vector<float> cluster_areas(cluster_count, 0.0f);
+        glm::vec3 mesh_centroid{0.0f};
+        float mesh_area{0.0f};
+
+        for (size_t i = 0; i < cluster_count; ++i) {
+            size_t end{i + 1 < cluster_count ? cluster_starts[i + 1] : triangle_count};
+            for (size_t triangle = cluster_starts[i]; triangle < end; ++triangle) {
+                const auto &a = vertices[indices[triangle * 3]].position;
+                const auto &b = vertices[indices[triangle * 3 + 1]].position;
+                const auto &c = vertices[indices[triangle * 3 + 2]].position;
+
+                glm::vec3 normal{glm::cross(b - a, c - a)};
+                float area{glm::length(normal)};
+                glm::vec3 centroid{(a + b + c) / 3.0f};
+
+                cluster_centroids[i] += centroid * area;
+                cluster_normals[i] += normal;
+                cluster_areas[i] += area;
+            }
+
+            mesh_centroid += cluster_centroids[i];
+            mesh_area += cluster_areas[i];
+        }
+        if (mesh_area > 0.0f) {
+            mesh_centroid /= mesh_area;
+        }
+
+        std::vector<float> cluster_sort_keys(cluster_count, 0.0f);
+        for (size_t i = 0; i < cluster_count; ++i) {
+            if (cluster_areas[i] > 0.0f) {
+                glm::vec3 centroid{cluster_centroids[i] / cluster_areas[i]};
+                glm::vec3 normal{cluster_normals[i] / cluster_areas[i]};
+                cluster_sort_keys[i] = glm::dot(centroid - mesh_centroid, normal);
+            }
+        }
+
+        std::vector<size_t> cluster_order(cluster_count);
+        std::iota(std::begin(cluster_order), std::end(cluster_order), 0);
+        std::stable_sort(std::begin(cluster_order), std::end(cluster_order), [&](size_t a, size_t b) {
+            return cluster_sort_keys[a] > cluster_sort_keys[b];
+        });
+
+        std::vector<unsigned int> result;
+        result.reserve(triangle_count * 3);
+        for (auto cluster : cluster_order) {
+            size_t begin{cluster_starts[cluster]};
+            size_t end{cluster + 1 < cluster_count ? cluster_starts[cluster + 1] : triangle_count};
+            result.insert(std::end(result), std::begin(indices) + begin * 3, std::begin(indices) + end * 3);
+        }
+        indices.swap(result);
+    }
+
+    // Renumbers vertices in the order the indices first reference them and drops the unreferenced ones.
+    static void optimize_vertex_fetch(std::vector<unsigned int> &indices, std::vector<Vertex> &vertices)
+    {
+        constexpr unsigned int unassigned{std::numeric_limits<unsigned int>::max()};
+
+        std::vector<unsigned int> remap(vertices.size(), unassigned);
+        std::vector<Vertex> ordered_vertices;
+        ordered_vertices.reserve(vertices.size());
+        for (auto &index : indices) {
+            if (remap[index] == unassigned) {
+                remap[index] = static_cast<unsigned int>(ordered_vertices.size());
+                ordered_vertices.push_back(vertices[index]);
+            }
+            index = remap[index];
+        }
+        vertices.swap(ordered_vertices);
+    }
+
+    static OptimizationStatistics optimize(
+        std::vector<unsigned int> &indices, std::vector<Vertex> &vertices,
+        size_t cache_size = DefaultVertexCacheSize, float overdraw_threshold = DefaultOverdrawThreshold
+    )
+    {
+        OptimizationStatistics statistics;
+        statistics.before = analyze_vertex_cache(indices, vertices.size(), cache_size);
+
+        indices.resize(indices.size() / 3 * 3);
+        deduplicate_vertices(indices, vertices);
+        remove_degenerate_triangles(indices);
+
+        std::vector<size_t> clusters;
+        indices = optimize_vertex_cache(indices, vertices.size(), cache_size, &clusters);
+        optimize_overdraw(indices, vertices, clusters, cache_size, overdraw_threshold);
+        optimize_vertex_fetch(indices, vertices);
+
+        statistics.after = analyze_vertex_cache(indices, vertices.size(), cache_size);
+
+        return statistics;
+    }
+}
+
+#endif
@@ -0,0 +1,275 @@
+#ifndef VERTEX_LAYOUT_H
+#define VERTEX_LAYOUT_H
+
+#include "geometries/vertex.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/packing.hpp>
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace asr
+{
+    /* Describes how vertices are packed in GPU memory. Geometries keep their full vertices on the CPU and convert the
+     * uploaded ranges to the layout, so attributes can be dropped or stored with smaller component types. Integer
+     * components are normalized to [0, 1] or [-1, 1]. Attributes missing from the layout fall back to the generic
+     * attribute values. */
+    class VertexLayout
+    {
+    public:
+        enum Attribute
+        {
+            Position,
+            Color,
+            Normal,
+            Tangent,
+            Binormal,
+            Texture1Coordinates,
+            Texture2Coordinates
+        };
+
+        static constexpr size_t AttributeCount{7};
+
+        enum ComponentType
+        {
+            Float,
+            HalfFloat,
+            NormalizedByte,
+            NormalizedUnsignedByte,
+            NormalizedShort,
+            NormalizedUnsignedShort
+        };
+
+        struct Element
+        {
+            Attribute attribute;
+            ComponentType component_type;
+            size_t component_count;
+            size_t offset;
+
+            bool operator==(const Element &other) const
+            {
+                return attribute == other.attribute && component_type == other.component_type &&
+                       component_count == other.component_count && offset == other.offset;
+            }
+        };
+
+        VertexLayout() = default;
+
+        // All attributes as floats in the order of Vertex, 100 bytes per vertex.
+        static const VertexLayout &get_default()
+        {
+            static const VertexLayout layout{
+                VertexLayout{}
+                    .add(Position, Float, 3)
+                    .add(Color, Float, 4)
+                    .add(Normal, Float, 3)
+                    .add(Tangent, Float, 4)
+                    .add(Binormal, Float, 3)
+                    .add(Texture1Coordinates, Float, 4)
+                    .add(Texture2Coordinates, Float, 4)
+            };
+
+            return layout;
+        }
+
+        // Positions only, 12 bytes per vertex, for plots and point clouds.
+        static const VertexLayout &get_position_layout()
+        {
+            static const VertexLayout layout{VertexLayout{}.add(Position, Float, 3)};
+
+            return layout;
+        }
+
+        // Positions, byte colours and normals and half float texture coordinates, 24 bytes per vertex.
+        static const VertexLayout &get_compact_layout()
+        {
+            static const VertexLayout layout{
+                VertexLayout{}
+                    .add(Position, Float, 3)
+                    .add(Color, NormalizedUnsignedByte, 4)
+                    .add(Normal, NormalizedByte, 3)
+                    .add(Texture1Coordinates, HalfFloat, 2)
+            };
+
+            return layout;
+        }
+
+        // The compact layout with tangents and binormals for normal mapping, 32 bytes per vertex.
+        static const VertexLayout &get_compact_normal_mapping_layout()
+        {
+            static const VertexLayout layout{
+                VertexLayout{}
+                    .add(Position, Float, 3)
+                    .add(Color, NormalizedUnsignedByte, 4)
+                    .add(Normal, NormalizedByte, 3)
+                    .add(Tangent, NormalizedByte, 4)
+                    .add(Binormal, NormalizedByte, 3)
+                    .add(Texture1Coordinates, HalfFloat, 2)
+            };
+
+            return layout;
+        }
+
+        static size_t get_component_size(ComponentType component_type)
+        {
+            switch (component_type) {
+                case Float:
+                    return 4;
+                case HalfFloat:
+                case NormalizedShort:
+                case NormalizedUnsignedShort:
+                    return 2;
+                case NormalizedByte:
+                case NormalizedUnsignedByte:
+                    return 1;
+            }
+
+            return 4;
+        }
+
+        // Elements start at four byte boundaries as recommended for vertex fetching.
+        VertexLayout &add(Attribute attribute, ComponentType component_type, size_t component_count)
+        {
+            _elements.push_back(Element{attribute, component_type, component_count, _stride});
+            _stride += (get_component_size(component_type) * component_count + 3) & ~size_t{3};
+
+            return *this;
+        }
+
+        [[nodiscard]] const std::vector<Element> &get_elements() const
+        {
+            return _elements;
+        }
+
+        [[nodiscard]] size_t get_stride() const
+        {
+            return _stride;
+        }
+
+        [[nodiscard]] const Element *find(Attribute attribute) const
+        {
+            for (const auto &element : _elements) {
+                if (element.attribute == attribute) {
+                    return &element;
+                }
+            }
+
+            return nullptr;
+        }
+
+        [[nodiscard]] bool has(Attribute attribute) const
+        {
+            return find(attribute) != nullptr;
+        }
+
+        // A copy with one component type substituted, for devices that lack support for it.
+        [[nodiscard]] VertexLayout replace_component_type(ComponentType component_type, ComponentType replacement) const
+        {
+            VertexLayout layout;
+            for (const auto &element : _elements) {
+                layout.add(
+                    element.attribute,
+                    element.component_type == component_type ? replacement : element.component_type,
+                    element.component_count
+                );
+            }
+
+            return layout;
+        }
+
+        bool operator==(const VertexLayout &other) const
+        {
+            return _stride == other._stride && _elements == other._elements;
+        }
+
+        bool operator!=(const VertexLayout &other) const
+        {
+            return !(*this == other);
+        }
+
+        // Writes vertices [begin, end) to data, which must hold (end - begin) * get_stride() bytes.
+        void pack(const std::vector<Vertex> &vertices, size_t begin, size_t end, uint8_t *data) const
+        {
+            if (*this == get_default()) {
+                std::memcpy(data, vertices.data() + begin, (end - begin) * sizeof(Vertex));
+                return;
+            }
+
+            std::memset(data, 0, (end - begin) * _stride);
+            for (size_t i = begin; i < end; ++i) {
+                const auto &vertex = vertices[i];
+                for (const auto &element : _elements) {
+                    glm::vec4 value{_get_attribute_value(vertex, element.attribute)};
+                    uint8_t *destination = data + element.offset;
+                    for (size_t component = 0; component < element.component_count; ++component) {
+                        _pack_component(value[static_cast<int>(component)], element.component_type, destination);
+                        destination += get_component_size(element.component_type);
+                    }
+                }
+                data += _stride;
+            }
+        }
+
+    private:
+        std::vector<Element> _elements;
+        size_t _stride{0};
+
+        static glm::vec4 _get_attribute_value(const Vertex &vertex, Attribute attribute)
+        {
+            switch (attribute) {
+                case Position:
+                    return glm::vec4{vertex.position, 1.0f};
+                case Color:
+                    return vertex.color;
+                case Normal:
+                    return glm::vec4{vertex.normal, 0.0f};
+                case Tangent:
+                    return vertex.tangent;
+                case Binormal:
+                    return glm::vec4{vertex.binormal, 0.0f};
+                case Texture1Coordinates:
+                    return vertex.texture1_coordinates;
+                case Texture2Coordinates:
+                    return vertex.texture2_coordinates;
+            }
+
+            return glm::vec4{0.0f};
+        }
+
+        static void _pack_component(float value, ComponentType component_type, uint8_t *destination)
+        {
+            switch (component_type) {
+                case Float:
+                    std::memcpy(destination, &value, sizeof(float));
+                    break;
+                case HalfFloat: {
+                    uint16_t half{glm::packHalf1x16(value)};
+                    std::memcpy(destination, &half, sizeof(uint16_t));
+                    break;
+                }
+                case NormalizedByte:
+                    *destination = glm::packSnorm1x8(value);
+                    break;
+                case NormalizedUnsignedByte:
+                    *destination = glm::packUnorm1x8(value);
+                    break;
+                case NormalizedShort: {
+                    uint16_t packed{glm::packSnorm1x16(value)};
+                    std::memcpy(destination, &packed, sizeof(uint16_t));
+                    break;
+                }
+                case NormalizedUnsignedShort: {
+                    uint16_t packed{glm::packUnorm1x16(value)};
+                    std::memcpy(destination, &packed, sizeof(uint16_t));
+                    break;
+                }
+            }
+        }
+    };
+}
+
+#endif
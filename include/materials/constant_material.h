@@ -6,6 +6,9 @@
 
 #include <glm/glm.hpp>
 
+#include <memory>
+#include <typeinfo>
+
 namespace asr
 {
     class ConstantMaterial : public Material
@@ -41,9 +44,52 @@ namespace asr
             _texture2 = texture_2;
         }
 
+        [[nodiscard]] const Texture *get_primary_texture() const override
+        {
+            return _texture1.get();
+        }
+
+        [[nodiscard]] const Texture *get_secondary_texture() const override
+        {
+            return _texture2.get();
+        }
+
+        [[nodiscard]] bool is_batchable_with(const Material &other) const override
+        {
+            if (this == &other) {
+                return true;
+            }
+            if (typeid(*this) != typeid(other)) {
+                return false;
+            }
+
+            const auto &constant_material = static_cast<const ConstantMaterial &>(other);
+
+            return _has_same_render_state_as(other) &&
+                   _emission_color == constant_material._emission_color &&
+                   _are_batchable_textures(_texture1.get(), constant_material._texture1.get()) &&
+                   _are_batchable_textures(_texture2.get(), constant_material._texture2.get());
+        }
+
     protected:
         glm::vec4 _emission_color{1.0f};
 
+        // Views of one image, such as frames of a sprite sheet, are interchangeable apart from their transformations.
+        static bool _are_batchable_textures(const Texture *a, const Texture *b)
+        {
+            if (a == b) {
+                return true;
+            }
+            if (a == nullptr || b == nullptr) {
+                return false;
+            }
+
+            return a->get_image_texture() == b->get_image_texture() &&
+                   a->is_enabled() == b->is_enabled() &&
+                   a->get_mode() == b->get_mode() &&
+                   a->is_transformation_enabled() == b->is_transformation_enabled();
+        }
+
         std::shared_ptr<Texture> _texture1;
         std::shared_ptr<Texture> _texture2;
     };
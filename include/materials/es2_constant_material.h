@@ -5,6 +5,8 @@
 
 #include "utilities/utilities.h"
 #include "renderer/es2_shader.h"
+#include "renderer/es2_shader_registry.h"
+#include "renderer/es2_state.h"
 
 #include <GL/glew.h>
 #define SDL_MAIN_HANDLED
@@ -31,242 +33,230 @@ namespace asr
                 "texture1_coordinates",
                 "texture2_coordinates"
             };
-            std::vector<std::string> uniforms{
-                "model_view_matrix",
-                "projection_matrix",
-                "emission_color",
-                "point_size",
-
-                "texture1_sampler",
-                "texture1_enabled",
-                "texture1_transformation_enabled",
-                "texture1_transformation_matrix",
-                "texturing_mode1",
-
-                "texture2_sampler",
-                "texture2_enabled",
-                "texture2_transformation_enabled",
-                "texture2_transformation_matrix",
-                "texturing_mode2",
-
-                "fog_enabled",
-                "fog_type",
-                "fog_depth",
-                "fog_color",
-                "fog_far_minus_near_plane",
-                "fog_far_plane",
-                "fog_density"
-            };
+            _mesh_shader = ES2ShaderRegistry::get_instance().get_shader(vertex_shader_source, fragment_shader_source, attributes);
+
+            std::vector<std::string> uniform_array_instancing_attributes{attributes};
+            uniform_array_instancing_attributes.emplace_back("instance_index");
+            _uniform_array_instanced_shader = ES2ShaderRegistry::get_instance().get_shader(
+                vertex_shader_source, fragment_shader_source, uniform_array_instancing_attributes, {},
+                "#define INSTANCING\n"
+                "#define INSTANCE_ARRAY_SIZE " + std::to_string(InstanceUniformArraySize) + "\n\n"
+            );
+
+            attributes.insert(std::end(attributes), {
+                "instance_model_matrix_column0",
+                "instance_model_matrix_column1",
+                "instance_model_matrix_column2",
+                "instance_model_matrix_column3",
+                "instance_color"
+            });
+            _instanced_shader = ES2ShaderRegistry::get_instance().get_shader(
+                vertex_shader_source, fragment_shader_source, attributes, {}, "#define INSTANCING\n\n"
+            );
+
+            // All variants register the same uniforms in the same order, so the handles are interchangeable.
+            _add_uniforms(*_mesh_shader);
+            _add_uniforms(*_instanced_shader);
+            _add_uniforms(*_uniform_array_instanced_shader);
+            _instance_inputs = _resolve_instance_inputs(*_instanced_shader);
+            _uniform_array_instance_inputs = _resolve_instance_inputs(*_uniform_array_instanced_shader);
+
+            _shader = _mesh_shader;
+        }
+
+        // Compiles the variants for single meshes and for instances with the instancing mode the device supports.
+        void precompile_shader_variants()
+        {
+            const auto &instanced_shader{GLEW_ARB_instanced_arrays ? _instanced_shader : _uniform_array_instanced_shader};
+            for (const auto &shader : {_mesh_shader, instanced_shader}) {
+                if (!shader->is_compiled() && !shader->is_dead()) {
+                    shader->compile();
+                }
+            }
+        }
+
+        [[nodiscard]] bool is_instancing_supported() const final
+        {
+            return true;
+        }
+
+        void update(const FrameUniforms &frame_uniforms, const std::shared_ptr<Mesh> &mesh) final
+        {
+            _shader = _mesh_shader;
+            _update(frame_uniforms, mesh);
+        }
+
+        void update_instanced(const FrameUniforms &frame_uniforms, InstancingMode instancing_mode) final
+        {
+            _shader = instancing_mode == InstanceUniformArrays ? _uniform_array_instanced_shader : _instanced_shader;
+            _update(frame_uniforms, nullptr);
+        }
+
+        [[nodiscard]] const InstanceInputs &get_instance_inputs() const final
+        {
+            return _shader == _uniform_array_instanced_shader ? _uniform_array_instance_inputs : _instance_inputs;
+        }
+
+        void use() final
+        {
+            _shader->use();
+
+            if (_texture1) {
+                _texture1->update(0);
+                _texture1->use(0);
+            }
+            if (_texture2) {
+                _texture2->update(1);
+                _texture2->use(1);
+            }
+        }
 
-            _shader = std::make_shared<ES2Shader>(vertex_shader_source, fragment_shader_source, attributes, uniforms);
+    private:
+        std::shared_ptr<Shader> _mesh_shader;
+        std::shared_ptr<Shader> _instanced_shader;
+        std::shared_ptr<Shader> _uniform_array_instanced_shader;
+        InstanceInputs _instance_inputs;
+        InstanceInputs _uniform_array_instance_inputs;
+
+        void _add_uniforms(Shader &shader)
+        {
+            _model_view_matrix_uniform = shader.add_uniform("model_view_matrix");
+            _view_matrix_uniform = shader.add_uniform("view_matrix");
+            _projection_matrix_uniform = shader.add_uniform("projection_matrix");
+            _instance_color_uniform = shader.add_uniform("instance_color");
+            _emission_color_uniform = shader.add_uniform("emission_color");
+            _point_size_uniform = shader.add_uniform("point_size");
+
+            _texture1_sampler_uniform = shader.add_uniform("texture1_sampler");
+            _texture1_enabled_uniform = shader.add_uniform("texture1_enabled");
+            _texture1_transformation_enabled_uniform = shader.add_uniform("texture1_transformation_enabled");
+            _texture1_transformation_matrix_uniform = shader.add_uniform("texture1_transformation_matrix");
+            _texturing_mode1_uniform = shader.add_uniform("texturing_mode1");
+
+            _texture2_sampler_uniform = shader.add_uniform("texture2_sampler");
+            _texture2_enabled_uniform = shader.add_uniform("texture2_enabled");
+            _texture2_transformation_enabled_uniform = shader.add_uniform("texture2_transformation_enabled");
+            _texture2_transformation_matrix_uniform = shader.add_uniform("texture2_transformation_matrix");
+            _texturing_mode2_uniform = shader.add_uniform("texturing_mode2");
+
+            _fog_enabled_uniform = shader.add_uniform("fog_enabled");
+            _fog_type_uniform = shader.add_uniform("fog_type");
+            _fog_depth_uniform = shader.add_uniform("fog_depth");
+            _fog_color_uniform = shader.add_uniform("fog_color");
+            _fog_far_minus_near_plane_uniform = shader.add_uniform("fog_far_minus_near_plane");
+            _fog_far_plane_uniform = shader.add_uniform("fog_far_plane");
+            _fog_density_uniform = shader.add_uniform("fog_density");
         }
 
-        void update(std::shared_ptr<Scene> scene, std::shared_ptr<Mesh> mesh) final
+        void _update(const FrameUniforms &frame_uniforms, const std::shared_ptr<Mesh> &mesh)
         {
             if (_shader->is_dead()) {
                 return;
             } else if (!_shader->is_compiled()) {
                 _shader->compile();
-                _shader->use();
-                if (_shader->is_dead()) { return; }
+                if (!_shader->is_compiled()) { return; }
             }
+            _shader->use();
+
+            auto &state = ES2State::get_instance();
 
             if (!_prefer_line_width_from_geometry) {
-                glLineWidth(static_cast<GLfloat>(_line_width));
+                state.set_line_width(_line_width);
             }
 
-            glDepthMask(static_cast<GLboolean>(_depth_mask_enabled));
-            if (_depth_test_enabled) {
-                glEnable(GL_DEPTH_TEST);
-            } else {
-                glDisable(GL_DEPTH_TEST);
-            }
+            state.set_depth_mask_enabled(_depth_mask_enabled);
+            state.set_depth_test_enabled(_depth_test_enabled);
             if (_depth_test_enabled) {
-                glDepthFunc(_convert_depth_test_func_to_es2_depth_test_func(_depth_test_function));
+                state.set_depth_test_function(_convert_depth_test_func_to_es2_depth_test_func(_depth_test_function));
             }
 
+            state.set_blending_enabled(_blending_enabled);
             if (_blending_enabled) {
-                glEnable(GL_BLEND);
-            } else {
-                glDisable(GL_BLEND);
-            }
-            if (_blending_enabled) {
-                glBlendEquationSeparate(_convert_blending_equation_to_es2_blending_equation(_color_blending_equation),
-                                        _convert_blending_equation_to_es2_blending_equation(_alpha_blending_equation));
-                glBlendFuncSeparate(_convert_blending_func_to_es2_blending_func(_source_color_blending_function),
-                                    _convert_blending_func_to_es2_blending_func(_destination_color_blending_function),
-                                    _convert_blending_func_to_es2_blending_func(_source_alpha_blending_function),
-                                    _convert_blending_func_to_es2_blending_func(_destination_alpha_blending_function));
-                glBlendColor(static_cast<GLclampf>(_blending_constant_color[0]),
-                             static_cast<GLclampf>(_blending_constant_color[1]),
-                             static_cast<GLclampf>(_blending_constant_color[2]),
-                             static_cast<GLclampf>(_blending_constant_color[3]));
+                state.set_blending_equations(_convert_blending_equation_to_es2_blending_equation(_color_blending_equation),
+                                             _convert_blending_equation_to_es2_blending_equation(_alpha_blending_equation));
+                state.set_blending_functions(_convert_blending_func_to_es2_blending_func(_source_color_blending_function),
+                                             _convert_blending_func_to_es2_blending_func(_destination_color_blending_function),
+                                             _convert_blending_func_to_es2_blending_func(_source_alpha_blending_function),
+                                             _convert_blending_func_to_es2_blending_func(_destination_alpha_blending_function));
+                state.set_blending_constant_color(_blending_constant_color);
             }
 
+            state.set_face_culling_enabled(_face_culling_enabled);
             if (_face_culling_enabled) {
-                glEnable(GL_CULL_FACE);
-            } else {
-                glDisable(GL_CULL_FACE);
-            }
-            if (_face_culling_enabled) {
-                glCullFace(_convert_cull_face_mode_to_es2_cull_face_mode(_cull_face_mode));
-                glFrontFace(_convert_front_face_order_to_es2_front_face_order(_front_face_order));
+                state.set_cull_face_mode(_convert_cull_face_mode_to_es2_cull_face_mode(_cull_face_mode));
+                state.set_front_face_order(_convert_front_face_order_to_es2_front_face_order(_front_face_order));
             }
 
+            state.set_polygon_offset_enabled(_polygon_offset_enabled);
             if (_polygon_offset_enabled) {
-                glEnable(GL_POLYGON_OFFSET_FILL);
-            } else {
-                glDisable(GL_POLYGON_OFFSET_FILL);
-            }
-            if (_polygon_offset_enabled) {
-                glPolygonOffset(static_cast<GLfloat>(_polygon_offset_factor),
-                                static_cast<GLfloat>(_polygon_offset_units));
+                state.set_polygon_offset(_polygon_offset_factor, _polygon_offset_units);
             }
 
-            auto camera = scene->get_camera();
-
-            glm::mat4 model_view_matrix;
-            if (is_overlay()) {
-                model_view_matrix = mesh->get_world_matrix();
-                model_view_matrix[3][2] = 0.0f;
+            if (mesh) {
+                if (const auto *draw_data = frame_uniforms.get_draw_data()) {
+                    _shader->set_uniform(_model_view_matrix_uniform, draw_data->model_view_matrix);
+                } else {
+                    glm::mat4 model_view_matrix;
+                    if (is_overlay()) {
+                        model_view_matrix = mesh->get_world_matrix();
+                        model_view_matrix[3][2] = 0.0f;
+                    } else {
+                        model_view_matrix = frame_uniforms.get_view_matrix() * mesh->get_world_matrix();
+                    }
+                    _shader->set_uniform(_model_view_matrix_uniform, model_view_matrix);
+                }
+                _shader->set_uniform(_instance_color_uniform, mesh->get_color());
             } else {
-                model_view_matrix = camera->get_view_matrix() * mesh->get_world_matrix();
+                _shader->set_uniform(_view_matrix_uniform, frame_uniforms.get_view_matrix());
             }
-            int model_view_matrix_uniform_location{_shader->get_uniforms().at("model_view_matrix")};
-            glUniformMatrix4fv(
-                model_view_matrix_uniform_location,
-                1, GL_FALSE,
-                glm::value_ptr(model_view_matrix)
-            );
 
-            glm::mat4 projection_matrix;
-            if (is_overlay()) {
-                projection_matrix = camera->get_orthographic_projection_matrix();
-            } else {
-                projection_matrix = camera->get_projection_matrix();
-            }
-            int projection_matrix_uniform_location{_shader->get_uniforms().at("projection_matrix")};
-            glUniformMatrix4fv(
-                projection_matrix_uniform_location,
-                1, GL_FALSE,
-                glm::value_ptr(projection_matrix)
+            _shader->set_uniform(
+                _projection_matrix_uniform,
+                is_overlay() ? frame_uniforms.get_orthographic_projection_matrix() : frame_uniforms.get_projection_matrix()
             );
 
-            if (_point_sizing_enabled && !_prefer_point_size_from_geometry) {
-                int point_size_uniform_location{_shader->get_uniforms().at("point_size")};
-                glUniform1f(point_size_uniform_location, _point_size);
-            }
-
-            int emission_color_uniform_location{_shader->get_uniforms().at("emission_color")};
-            glUniform4fv(
-                emission_color_uniform_location,
-                1, glm::value_ptr(_emission_color)
+            _shader->set_uniform(
+                _point_size_uniform,
+                _point_sizing_enabled && !_prefer_point_size_from_geometry ? _point_size : 0.0f
             );
 
+            _shader->set_uniform(_emission_color_uniform, _emission_color);
+
             if (_texture1) {
-                int texture1_enabled_uniform_location{_shader->get_uniforms().at("texture1_enabled")};
-                glUniform1i(
-                    texture1_enabled_uniform_location,
-                    static_cast<GLint>(_texture1->is_enabled())
-                );
+                _shader->set_uniform(_texture1_enabled_uniform, static_cast<GLint>(_texture1->is_enabled()));
 
                 if (_texture1->is_enabled()) {
-                    int texture1_sampler_uniform_location{_shader->get_uniforms().at("texture1_sampler")};
-                    glUniform1i(texture1_sampler_uniform_location, 0);
-
-                    int texturing_mode1_uniform_location{_shader->get_uniforms().at("texturing_mode1")};
-                    glUniform1i(
-                        texturing_mode1_uniform_location,
-                        static_cast<GLint>(_texture1->get_mode())
-                    );
-
-                    int texture1_transformation_enabled_uniform_location{_shader->get_uniforms().at("texture1_transformation_enabled")};
-                    glUniform1i(
-                        texture1_transformation_enabled_uniform_location,
-                        static_cast<GLint>(_texture1->is_transformation_enabled())
-                    );
-
-                    int texture1_transformation_matrix_uniform_location{_shader->get_uniforms().at("texture1_transformation_matrix")};
-                    glUniformMatrix4fv(
-                        texture1_transformation_matrix_uniform_location,
-                        1, GL_FALSE,
-                        glm::value_ptr(_texture1->get_transformation_matrix())
-                    );
+                    _shader->set_uniform(_texture1_sampler_uniform, 0);
+                    _shader->set_uniform(_texturing_mode1_uniform, static_cast<GLint>(_texture1->get_mode()));
+                    _shader->set_uniform(_texture1_transformation_enabled_uniform, static_cast<GLint>(_texture1->is_transformation_enabled()));
+                    _shader->set_uniform(_texture1_transformation_matrix_uniform, _texture1->get_transformation_matrix());
                 }
+            } else {
+                _shader->set_uniform(_texture1_enabled_uniform, 0);
             }
 
             if (_texture2) {
-                int texture2_enabled_uniform_location{_shader->get_uniforms().at("texture2_enabled")};
-                glUniform1i(
-                    texture2_enabled_uniform_location,
-                    static_cast<GLint>(_texture2->is_enabled())
-                );
+                _shader->set_uniform(_texture2_enabled_uniform, static_cast<GLint>(_texture2->is_enabled()));
 
                 if (_texture2->is_enabled()) {
-                    int texture2_sampler_uniform_location{_shader->get_uniforms().at("texture2_sampler")};
-                    glUniform1i(texture2_sampler_uniform_location, 1);
-
-                    int texturing_mode2_uniform_location{_shader->get_uniforms().at("texturing_mode2")};
-                    glUniform1i(
-                        texturing_mode2_uniform_location,
-                        static_cast<GLint>(_texture2->get_mode())
-                    );
-
-                    int texture2_transformation_enabled_uniform_location{_shader->get_uniforms().at("texture2_transformation_enabled")};
-                    glUniform1i(
-                        texture2_transformation_enabled_uniform_location,
-                        static_cast<GLint>(_texture2->is_transformation_enabled())
-                    );
-
-                    int texture2_transformation_matrix_uniform_location{_shader->get_uniforms().at("texture2_transformation_matrix")};
-                    glUniformMatrix4fv(
-                        texture2_transformation_matrix_uniform_location,
-                        1, GL_FALSE,
-                        glm::value_ptr(_texture2->get_transformation_matrix())
-                    );
+                    _shader->set_uniform(_texture2_sampler_uniform, 1);
+                    _shader->set_uniform(_texturing_mode2_uniform, static_cast<GLint>(_texture2->get_mode()));
+                    _shader->set_uniform(_texture2_transformation_enabled_uniform, static_cast<GLint>(_texture2->is_transformation_enabled()));
+                    _shader->set_uniform(_texture2_transformation_matrix_uniform, _texture2->get_transformation_matrix());
                 }
+            } else {
+                _shader->set_uniform(_texture2_enabled_uniform, 0);
             }
 
-            int fog_enabled_uniform_location{_shader->get_uniforms().at("fog_enabled")};
-            glUniform1i(fog_enabled_uniform_location, static_cast<GLint>(_fog_enabled));
-
-            int fog_type_uniform_location{_shader->get_uniforms().at("fog_type")};
-            glUniform1i(fog_type_uniform_location, static_cast<GLint>(_fog_type));
-
-            int fog_depth_uniform_location{_shader->get_uniforms().at("fog_depth")};
-            glUniform1i(fog_depth_uniform_location, static_cast<GLint>(_fog_depth));
-
-            int fog_color_uniform_location{_shader->get_uniforms().at("fog_color")};
-            glUniform3fv(
-                fog_color_uniform_location,
-                1, glm::value_ptr(_fog_color)
-            );
-
-            int fog_far_minus_near_plane_uniform_location{_shader->get_uniforms().at("fog_far_minus_near_plane")};
-            glUniform1f(fog_far_minus_near_plane_uniform_location, _fog_far_plane - _fog_near_plane);
-
-            int fog_far_plane_uniform_location{_shader->get_uniforms().at("fog_far_plane")};
-            glUniform1f(fog_far_plane_uniform_location, _fog_far_plane);
-
-            int fog_density_uniform_location{_shader->get_uniforms().at("fog_density")};
-            glUniform1f(fog_density_uniform_location, _fog_density);
-        }
-
-        void use() final
-        {
-            _shader->use();
-
-            if (_texture1) {
-                _texture1->update(0);
-                _texture1->use(0);
-            }
-            if (_texture2) {
-                _texture2->update(1);
-                _texture2->use(1);
-            }
+            _shader->set_uniform(_fog_enabled_uniform, static_cast<GLint>(_fog_enabled));
+            _shader->set_uniform(_fog_type_uniform, static_cast<GLint>(_fog_type));
+            _shader->set_uniform(_fog_depth_uniform, static_cast<GLint>(_fog_depth));
+            _shader->set_uniform(_fog_color_uniform, _fog_color);
+            _shader->set_uniform(_fog_far_minus_near_plane_uniform, _fog_far_plane - _fog_near_plane);
+            _shader->set_uniform(_fog_far_plane_uniform, _fog_far_plane);
+            _shader->set_uniform(_fog_density_uniform, _fog_density);
         }
 
-    private:
         static GLenum _convert_depth_test_func_to_es2_depth_test_func(Material::DepthTestFunction depth_test_function)
         {
             switch (depth_test_function) {
@@ -368,6 +358,30 @@ namespace asr
 
             return GL_CW;
         }
+
+        Shader::Uniform _model_view_matrix_uniform;
+        Shader::Uniform _view_matrix_uniform;
+        Shader::Uniform _projection_matrix_uniform;
+        Shader::Uniform _instance_color_uniform;
+        Shader::Uniform _emission_color_uniform;
+        Shader::Uniform _point_size_uniform;
+        Shader::Uniform _texture1_sampler_uniform;
+        Shader::Uniform _texture1_enabled_uniform;
+        Shader::Uniform _texture1_transformation_enabled_uniform;
+        Shader::Uniform _texture1_transformation_matrix_uniform;
+        Shader::Uniform _texturing_mode1_uniform;
+        Shader::Uniform _texture2_sampler_uniform;
+        Shader::Uniform _texture2_enabled_uniform;
+        Shader::Uniform _texture2_transformation_enabled_uniform;
+        Shader::Uniform _texture2_transformation_matrix_uniform;
+        Shader::Uniform _texturing_mode2_uniform;
+        Shader::Uniform _fog_enabled_uniform;
+        Shader::Uniform _fog_type_uniform;
+        Shader::Uniform _fog_depth_uniform;
+        Shader::Uniform _fog_color_uniform;
+        Shader::Uniform _fog_far_minus_near_plane_uniform;
+        Shader::Uniform _fog_far_plane_uniform;
+        Shader::Uniform _fog_density_uniform;
     };
 }
 
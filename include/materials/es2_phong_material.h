@@ -5,6 +5,8 @@
 
 #include "utilities/utilities.h"
 #include "renderer/es2_shader.h"
+#include "renderer/es2_shader_registry.h"
+#include "renderer/es2_state.h"
 
 #include <GL/glew.h>
 #define SDL_MAIN_HANDLED
@@ -16,6 +18,8 @@
 #include <string>
 #include <vector>
 #include <memory>
+#include <map>
+#include <tuple>
 #include <cstddef>
 
 namespace asr
@@ -28,605 +32,511 @@ namespace asr
             _vertex_shader_source = file_utilities::read_text_file("data/shaders/es2_phong_shader.vert");
             _fragment_shader_source = file_utilities::read_text_file("data/shaders/es2_phong_shader.frag");
 
-            std::vector<std::string> attributes{
-                "position",
-                "color",
-                "normal",
-                "tangent",
-                "binormal",
-                "texture1_coordinates",
-                "texture2_coordinates"
-            };
-            std::vector<std::string> uniforms{
-                "model_view_matrix",
-                "projection_matrix",
-                "normal_matrix",
-                "point_size",
-
-                "ambient_light_color",
-
-                "material_ambient_color",
-                "material_diffuse_color",
-                "material_emission_color",
-                "material_specular_color",
-                "material_specular_exponent",
-
-                "directional_light_enabled[0]",
-                "directional_light_two_sided[0]",
-                "directional_light_view_direction[0]",
-                "directional_light_ambient_color[0]",
-                "directional_light_diffuse_color[0]",
-                "directional_light_specular_color[0]",
-                "directional_light_intensity[0]",
-
-                "point_light_enabled[0]",
-                "point_light_two_sided[0]",
-                "point_light_view_position[0]",
-                "point_light_ambient_color[0]",
-                "point_light_diffuse_color[0]",
-                "point_light_specular_color[0]",
-                "point_light_intensity[0]",
-                "point_light_constant_attenuation[0]",
-                "point_light_linear_attenuation[0]",
-                "point_light_quadratic_attenuation[0]",
-
-                "texture1_sampler",
-                "texture1_enabled",
-                "texture1_transformation_enabled",
-                "texture1_transformation_matrix",
-                "texturing_mode1",
-                "texture1_normals_sampler",
-                "texture1_normals_enabled",
-
-                "texture2_sampler",
-                "texture2_enabled",
-                "texture2_transformation_enabled",
-                "texture2_transformation_matrix",
-                "texturing_mode2",
-
-                "fog_enabled",
-                "fog_type",
-                "fog_depth",
-                "fog_color",
-                "fog_far_minus_near_plane",
-                "fog_far_plane",
-                "fog_density"
-            };
-
-            _shader = std::make_shared<ES2Shader>(_vertex_shader_source, _fragment_shader_source, attributes, uniforms);
+            _use_shader_variant(
+                _previous_directional_light_count, _previous_point_light_count, _previous_spot_light_count,
+                _previous_instanced, _previous_instancing_mode
+            );
+        }
+
+        // Compiles the variants for single meshes and for instances with the instancing mode the device supports.
+        void precompile_shader_variants(
+            size_t max_directional_light_count, size_t max_point_light_count, size_t max_spot_light_count
+        )
+        {
+            InstancingMode instancing_mode{GLEW_ARB_instanced_arrays ? InstanceAttributes : InstanceUniformArrays};
+            for (size_t i = 0; i <= max_directional_light_count; ++i) {
+                for (size_t j = 0; j <= max_point_light_count; ++j) {
+                    for (size_t k = 0; k <= max_spot_light_count; ++k) {
+                        for (bool instanced : {false, true}) {
+                            const auto &shader = _get_shader_variant(i, j, k, instanced, instancing_mode).shader;
+                            if (!shader->is_compiled() && !shader->is_dead()) {
+                                shader->compile();
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+        [[nodiscard]] bool is_instancing_supported() const final
+        {
+            return true;
         }
 
-        void update(std::shared_ptr<Scene> scene, std::shared_ptr<Mesh> mesh) final
+        void update(const FrameUniforms &frame_uniforms, const std::shared_ptr<Mesh> &mesh) final
         {
+            _update(frame_uniforms, mesh, InstanceAttributes);
+        }
+
+        void update_instanced(const FrameUniforms &frame_uniforms, InstancingMode instancing_mode) final
+        {
+            _update(frame_uniforms, nullptr, instancing_mode);
+        }
+
+        [[nodiscard]] const InstanceInputs &get_instance_inputs() const final
+        {
+            return _shader_variant->instance_inputs;
+        }
+
+        void use() final
+        {
+            _shader->use();
+
+            if (_texture1) {
+                _texture1->use(0);
+            }
+            if (_texture2) {
+                _texture2->use(1);
+            }
+            if (_texture1_normals) {
+                _texture1_normals->use(2);
+            }
+        }
+
+    private:
+        void _update(const FrameUniforms &frame_uniforms, const std::shared_ptr<Mesh> &mesh, InstancingMode instancing_mode)
+        {
+            _update_shader_variant_if_necessary(frame_uniforms, !mesh, instancing_mode);
+
             if (_shader->is_dead()) {
                 return;
             } else if (!_shader->is_compiled()) {
                 _shader->compile();
-                _shader->use();
-                if (_shader->is_dead()) { return; }
+                if (!_shader->is_compiled()) { return; }
             }
+            _shader->use();
+
+            auto &state = ES2State::get_instance();
 
             if (!_prefer_line_width_from_geometry) {
-                glLineWidth(static_cast<GLfloat>(_line_width));
+                state.set_line_width(_line_width);
             }
 
-            glDepthMask(static_cast<GLboolean>(_depth_mask_enabled));
+            state.set_depth_mask_enabled(_depth_mask_enabled);
+            state.set_depth_test_enabled(_depth_test_enabled);
             if (_depth_test_enabled) {
-                glEnable(GL_DEPTH_TEST);
-            } else {
-                glDisable(GL_DEPTH_TEST);
-            }
-            if (_depth_test_enabled) {
-                glDepthFunc(_convert_depth_test_func_to_es2_depth_test_func(_depth_test_function));
+                state.set_depth_test_function(_convert_depth_test_func_to_es2_depth_test_func(_depth_test_function));
             }
 
+            state.set_blending_enabled(_blending_enabled);
             if (_blending_enabled) {
-                glEnable(GL_BLEND);
-            } else {
-                glDisable(GL_BLEND);
-            }
-            if (_blending_enabled) {
-                glBlendEquationSeparate(_convert_blending_equation_to_es2_blending_equation(_color_blending_equation),
-                                        _convert_blending_equation_to_es2_blending_equation(_alpha_blending_equation));
-                glBlendFuncSeparate(_convert_blending_func_to_es2_blending_func(_source_color_blending_function),
-                                    _convert_blending_func_to_es2_blending_func(_destination_color_blending_function),
-                                    _convert_blending_func_to_es2_blending_func(_source_alpha_blending_function),
-                                    _convert_blending_func_to_es2_blending_func(_destination_alpha_blending_function));
-                glBlendColor(static_cast<GLclampf>(_blending_constant_color[0]),
-                             static_cast<GLclampf>(_blending_constant_color[1]),
-                             static_cast<GLclampf>(_blending_constant_color[2]),
-                             static_cast<GLclampf>(_blending_constant_color[3]));
+                state.set_blending_equations(_convert_blending_equation_to_es2_blending_equation(_color_blending_equation),
+                                             _convert_blending_equation_to_es2_blending_equation(_alpha_blending_equation));
+                state.set_blending_functions(_convert_blending_func_to_es2_blending_func(_source_color_blending_function),
+                                             _convert_blending_func_to_es2_blending_func(_destination_color_blending_function),
+                                             _convert_blending_func_to_es2_blending_func(_source_alpha_blending_function),
+                                             _convert_blending_func_to_es2_blending_func(_destination_alpha_blending_function));
+                state.set_blending_constant_color(_blending_constant_color);
             }
 
+            state.set_face_culling_enabled(_face_culling_enabled);
             if (_face_culling_enabled) {
-                glEnable(GL_CULL_FACE);
-            } else {
-                glDisable(GL_CULL_FACE);
-            }
-            if (_face_culling_enabled) {
-                glCullFace(_convert_cull_face_mode_to_es2_cull_face_mode(_cull_face_mode));
-                glFrontFace(_convert_front_face_order_to_es2_front_face_order(_front_face_order));
+                state.set_cull_face_mode(_convert_cull_face_mode_to_es2_cull_face_mode(_cull_face_mode));
+                state.set_front_face_order(_convert_front_face_order_to_es2_front_face_order(_front_face_order));
             }
 
+            state.set_polygon_offset_enabled(_polygon_offset_enabled);
             if (_polygon_offset_enabled) {
-                glEnable(GL_POLYGON_OFFSET_FILL);
-            } else {
-                glDisable(GL_POLYGON_OFFSET_FILL);
-            }
-            if (_polygon_offset_enabled) {
-                glPolygonOffset(static_cast<GLfloat>(_polygon_offset_factor),
-                                static_cast<GLfloat>(_polygon_offset_units));
+                state.set_polygon_offset(_polygon_offset_factor, _polygon_offset_units);
             }
 
-            _update_light_uniforms_if_necessary(scene);
-            if (_shader->is_dead()) { return; }
+            if (mesh) {
+                if (const auto *draw_data = frame_uniforms.get_draw_data()) {
+                    _shader->set_uniform(_shader_variant->model_view_matrix, draw_data->model_view_matrix);
+                    _shader->set_uniform(_shader_variant->normal_matrix, draw_data->normal_matrix);
+                } else {
+                    glm::mat4 model_view_matrix;
+                    if (is_overlay()) {
+                        model_view_matrix = mesh->get_world_matrix();
+                        model_view_matrix[3][2] = 0.0f;
+                    } else {
+                        model_view_matrix = frame_uniforms.get_view_matrix() * mesh->get_world_matrix();
+                    }
+                    _shader->set_uniform(_shader_variant->model_view_matrix, model_view_matrix);
 
-            auto camera = scene->get_camera();
+                    glm::mat3 normal_matrix = glm::inverseTranspose(glm::mat3(model_view_matrix));
+                    _shader->set_uniform(_shader_variant->normal_matrix, normal_matrix);
+                }
 
-            glm::mat4 model_view_matrix;
-            if (is_overlay()) {
-                model_view_matrix = mesh->get_world_matrix();
-                model_view_matrix[3][2] = 0.0f;
+                _shader->set_uniform(_shader_variant->instance_color, mesh->get_color());
             } else {
-                model_view_matrix = camera->get_view_matrix() * mesh->get_world_matrix();
+                _shader->set_uniform(_shader_variant->view_matrix, frame_uniforms.get_view_matrix());
             }
-            int model_view_matrix_uniform_location{_shader->get_uniforms().at("model_view_matrix")};
-            glUniformMatrix4fv(
-                model_view_matrix_uniform_location,
-                1, GL_FALSE,
-                glm::value_ptr(model_view_matrix)
-            );
 
-            glm::mat4 projection_matrix;
-            if (is_overlay()) {
-                projection_matrix = camera->get_orthographic_projection_matrix();
-            } else {
-                projection_matrix = camera->get_projection_matrix();
-            }
-            int projection_matrix_uniform_location{_shader->get_uniforms().at("projection_matrix")};
-            glUniformMatrix4fv(
-                projection_matrix_uniform_location,
-                1, GL_FALSE,
-                glm::value_ptr(projection_matrix)
+            _shader->set_uniform(
+                _shader_variant->projection_matrix,
+                is_overlay() ? frame_uniforms.get_orthographic_projection_matrix() : frame_uniforms.get_projection_matrix()
             );
 
-            glm::mat3 normal_matrix = glm::inverseTranspose(glm::mat3(model_view_matrix));
-            int normal_matrix_uniform_location{_shader->get_uniforms().at("normal_matrix")};
-            glUniformMatrix3fv(
-                normal_matrix_uniform_location,
-                1, GL_FALSE,
-                glm::value_ptr(normal_matrix)
+            _shader->set_uniform(
+                _shader_variant->point_size,
+                _point_sizing_enabled && !_prefer_point_size_from_geometry ? _point_size : 0.0f
             );
 
-            if (_point_sizing_enabled && !_prefer_point_size_from_geometry) {
-                int point_size_uniform_location{_shader->get_uniforms().at("point_size")};
-                glUniform1f(point_size_uniform_location, _point_size);
-            }
-
-            int ambient_light_color_uniform_location{_shader->get_uniforms().at("ambient_light_color")};
-            glUniform3fv(
-                ambient_light_color_uniform_location,
-                1, glm::value_ptr(scene->get_ambient_light()->get_ambient_color())
-            );
-
-            int material_ambient_color_uniform_location{_shader->get_uniforms().at("material_ambient_color")};
-            glUniform3fv(
-                material_ambient_color_uniform_location,
-                1, glm::value_ptr(_ambient_color)
-            );
-
-            int material_diffuse_color_uniform_location{_shader->get_uniforms().at("material_diffuse_color")};
-            glUniform4fv(
-                material_diffuse_color_uniform_location,
-                1, glm::value_ptr(_diffuse_color)
-            );
-
-            int material_emission_color_uniform_location{_shader->get_uniforms().at("material_emission_color")};
-            glUniform4fv(
-                material_emission_color_uniform_location,
-                1, glm::value_ptr(_emission_color)
-            );
-
-            int material_specular_color_uniform_location{_shader->get_uniforms().at("material_specular_color")};
-            glUniform3fv(
-                material_specular_color_uniform_location,
-                1, glm::value_ptr(_specular_color)
-            );
-
-            int material_specular_exponent_uniform_location{_shader->get_uniforms().at("material_specular_exponent")};
-            glUniform1f(material_specular_exponent_uniform_location, _specular_exponent);
-
-            auto &directional_lights = scene->get_directional_lights();
-            for (std::vector<std::shared_ptr<DirectionalLight>>::size_type i = 0; i < directional_lights.size(); ++i) {
-                const auto &directional_light = directional_lights[i];
-
-                int uniform_location = _shader->get_uniforms().at(_uniform_at_index("directional_light_enabled", i));
-                glUniform1i(uniform_location, directional_light->is_enabled());
-
-                uniform_location = _shader->get_uniforms().at(_uniform_at_index("directional_light_two_sided", i));
-                glUniform1i(uniform_location, directional_light->is_two_sided());
-
-                uniform_location = _shader->get_uniforms().at(_uniform_at_index("directional_light_view_direction", i));
-                glUniform3fv(
-                    uniform_location,
-                    1, glm::value_ptr(camera->get_view_matrix() * glm::vec4(directional_light->get_world_direction(), 0.0f))
-                );
-
-                uniform_location = _shader->get_uniforms().at(_uniform_at_index("directional_light_ambient_color", i));
-                glUniform3fv(
-                    uniform_location,
-                    1, glm::value_ptr(directional_light->get_ambient_color())
-                );
-
-                uniform_location = _shader->get_uniforms().at(_uniform_at_index("directional_light_diffuse_color", i));
-                glUniform3fv(
-                    uniform_location,
-                    1, glm::value_ptr(directional_light->get_diffuse_color())
-                );
-
-                uniform_location = _shader->get_uniforms().at(_uniform_at_index("directional_light_specular_color", i));
-                glUniform3fv(
-                    uniform_location,
-                    1, glm::value_ptr(directional_light->get_specular_color())
-                );
-
-                uniform_location = _shader->get_uniforms().at(_uniform_at_index("directional_light_intensity", i));
-                glUniform1f(uniform_location, directional_light->get_intensity());
-            }
-
-            auto &point_lights = scene->get_point_lights();
-            for (std::vector<std::shared_ptr<PointLight>>::size_type i = 0; i < point_lights.size(); ++i) {
-                const auto &point_light = point_lights[i];
-
-                int uniform_location = _shader->get_uniforms().at(_uniform_at_index("point_light_enabled", i));
-                glUniform1i(uniform_location, point_light->is_enabled());
-
-                uniform_location = _shader->get_uniforms().at(_uniform_at_index("point_light_two_sided", i));
-                glUniform1i(uniform_location, point_light->is_two_sided());
-
-                uniform_location = _shader->get_uniforms().at(_uniform_at_index("point_light_view_position", i));
-                glUniform3fv(
-                    uniform_location,
-                    1, glm::value_ptr(camera->get_view_matrix() * point_light->get_world_matrix() * glm::vec4(point_light->get_position(), 1.0f))
-                );
-
-                uniform_location = _shader->get_uniforms().at(_uniform_at_index("point_light_ambient_color", i));
-                glUniform3fv(
-                    uniform_location,
-                    1, glm::value_ptr(point_light->get_ambient_color())
-                );
-
-                uniform_location = _shader->get_uniforms().at(_uniform_at_index("point_light_diffuse_color", i));
-                glUniform3fv(
-                    uniform_location,
-                    1, glm::value_ptr(point_light->get_diffuse_color())
-                );
-
-                uniform_location = _shader->get_uniforms().at(_uniform_at_index("point_light_specular_color", i));
-                glUniform3fv(
-                    uniform_location,
-                    1, glm::value_ptr(point_light->get_specular_color())
-                );
-
-                uniform_location = _shader->get_uniforms().at(_uniform_at_index("point_light_intensity", i));
-                glUniform1f(uniform_location, point_light->get_intensity());
-
-                uniform_location = _shader->get_uniforms().at(_uniform_at_index("point_light_constant_attenuation", i));
-                glUniform1f(uniform_location, point_light->get_constant_attenuation());
-
-                uniform_location = _shader->get_uniforms().at(_uniform_at_index("point_light_linear_attenuation", i));
-                glUniform1f(uniform_location, point_light->get_linear_attenuation());
+            _shader->set_uniform(_shader_variant->material_ambient_color, _ambient_color);
+            _shader->set_uniform(_shader_variant->material_diffuse_color, _diffuse_color);
+            _shader->set_uniform(_shader_variant->material_emission_color, _emission_color);
+            _shader->set_uniform(_shader_variant->material_specular_color, _specular_color);
+            _shader->set_uniform(_shader_variant->material_specular_exponent, _specular_exponent);
 
-                uniform_location = _shader->get_uniforms().at(_uniform_at_index("point_light_quadratic_attenuation", i));
-                glUniform1f(uniform_location, point_light->get_quadratic_attenuation());
-            }
-
-            auto &spot_lights = scene->get_spot_lights();
-            for (std::vector<std::shared_ptr<SpotLight>>::size_type i = 0; i < spot_lights.size(); ++i) {
-                const auto &spot_light = spot_lights[i];
-
-                int uniform_location = _shader->get_uniforms().at(_uniform_at_index("spot_light_enabled", i));
-                glUniform1i(uniform_location, spot_light->is_enabled());
-
-                uniform_location = _shader->get_uniforms().at(_uniform_at_index("spot_light_two_sided", i));
-                glUniform1i(uniform_location, spot_light->is_two_sided());
-
-                uniform_location = _shader->get_uniforms().at(_uniform_at_index("spot_light_view_position", i));
-                glUniform3fv(
-                    uniform_location,
-                    1, glm::value_ptr(camera->get_view_matrix() * spot_light->get_world_matrix() * glm::vec4(spot_light->get_position(), 1.0f))
-                );
-
-                uniform_location = _shader->get_uniforms().at(_uniform_at_index("spot_light_view_direction", i));
-                glUniform3fv(
-                    uniform_location,
-                    1, glm::value_ptr(camera->get_view_matrix() * glm::vec4(spot_light->get_world_direction(), 0.0f))
-                );
-
-                uniform_location = _shader->get_uniforms().at(_uniform_at_index("spot_light_ambient_color", i));
-                glUniform3fv(
-                    uniform_location,
-                    1, glm::value_ptr(spot_light->get_ambient_color())
-                );
-
-                uniform_location = _shader->get_uniforms().at(_uniform_at_index("spot_light_diffuse_color", i));
-                glUniform3fv(
-                    uniform_location,
-                    1, glm::value_ptr(spot_light->get_diffuse_color())
-                );
-
-                uniform_location = _shader->get_uniforms().at(_uniform_at_index("spot_light_specular_color", i));
-                glUniform3fv(
-                    uniform_location,
-                    1, glm::value_ptr(spot_light->get_specular_color())
-                );
-
-                uniform_location = _shader->get_uniforms().at(_uniform_at_index("spot_light_exponent", i));
-                glUniform1f(uniform_location, spot_light->get_exponent());
-
-                uniform_location = _shader->get_uniforms().at(_uniform_at_index("spot_light_cutoff_angle_cosine", i));
-                glUniform1f(uniform_location, spot_light->get_cutoff_angle());
-
-                uniform_location = _shader->get_uniforms().at(_uniform_at_index("spot_light_intensity", i));
-                glUniform1f(uniform_location, spot_light->get_intensity());
-
-                uniform_location = _shader->get_uniforms().at(_uniform_at_index("spot_light_constant_attenuation", i));
-                glUniform1f(uniform_location, spot_light->get_constant_attenuation());
-
-                uniform_location = _shader->get_uniforms().at(_uniform_at_index("spot_light_linear_attenuation", i));
-                glUniform1f(uniform_location, spot_light->get_linear_attenuation());
-
-                uniform_location = _shader->get_uniforms().at(_uniform_at_index("spot_light_quadratic_attenuation", i));
-                glUniform1f(uniform_location, spot_light->get_quadratic_attenuation());
+            if (_shader->get_frame_uniforms_frame() != frame_uniforms.get_frame()) {
+                _update_frame_uniforms(frame_uniforms);
             }
 
             if (_texture1) {
                 _texture1->update(0);
 
-                int texture1_enabled_uniform_location{_shader->get_uniforms().at("texture1_enabled")};
-                glUniform1i(
-                    texture1_enabled_uniform_location,
-                    static_cast<GLint>(_texture1->is_enabled())
-                );
+                _shader->set_uniform(_shader_variant->texture1_enabled, static_cast<GLint>(_texture1->is_enabled()));
 
                 if (_texture1->is_enabled()) {
-                    int texture1_sampler_uniform_location{_shader->get_uniforms().at("texture1_sampler")};
-                    glUniform1i(texture1_sampler_uniform_location, 0);
-
-                    int texturing_mode1_uniform_location{_shader->get_uniforms().at("texturing_mode1")};
-                    glUniform1i(
-                        texturing_mode1_uniform_location,
-                        static_cast<GLint>(_texture1->get_mode())
-                    );
-
-                    int texture1_transformation_enabled_uniform_location{_shader->get_uniforms().at("texture1_transformation_enabled")};
-                    glUniform1i(
-                        texture1_transformation_enabled_uniform_location,
-                        static_cast<GLint>(_texture1->is_transformation_enabled())
-                    );
-
-                    int texture1_transformation_matrix_uniform_location{_shader->get_uniforms().at("texture1_transformation_matrix")};
-                    glUniformMatrix4fv(
-                        texture1_transformation_matrix_uniform_location,
-                        1, GL_FALSE,
-                        glm::value_ptr(_texture1->get_transformation_matrix())
-                    );
+                    _shader->set_uniform(_shader_variant->texture1_sampler, 0);
+                    _shader->set_uniform(_shader_variant->texturing_mode1, static_cast<GLint>(_texture1->get_mode()));
+                    _shader->set_uniform(_shader_variant->texture1_transformation_enabled, static_cast<GLint>(_texture1->is_transformation_enabled()));
+                    _shader->set_uniform(_shader_variant->texture1_transformation_matrix, _texture1->get_transformation_matrix());
                 }
+            } else {
+                _shader->set_uniform(_shader_variant->texture1_enabled, 0);
             }
 
             if (_texture2) {
                 _texture2->update(1);
 
-                int texture2_enabled_uniform_location{_shader->get_uniforms().at("texture2_enabled")};
-                glUniform1i(
-                    texture2_enabled_uniform_location,
-                    static_cast<GLint>(_texture2->is_enabled())
-                );
+                _shader->set_uniform(_shader_variant->texture2_enabled, static_cast<GLint>(_texture2->is_enabled()));
 
                 if (_texture2->is_enabled()) {
-                    int texture2_sampler_uniform_location{_shader->get_uniforms().at("texture2_sampler")};
-                    glUniform1i(texture2_sampler_uniform_location, 1);
-
-                    int texturing_mode2_uniform_location{_shader->get_uniforms().at("texturing_mode2")};
-                    glUniform1i(
-                        texturing_mode2_uniform_location,
-                        static_cast<GLint>(_texture2->get_mode())
-                    );
-
-                    int texture2_transformation_enabled_uniform_location{_shader->get_uniforms().at("texture2_transformation_enabled")};
-                    glUniform1i(
-                        texture2_transformation_enabled_uniform_location,
-                        static_cast<GLint>(_texture2->is_transformation_enabled())
-                    );
-
-                    int texture2_transformation_matrix_uniform_location{_shader->get_uniforms().at("texture2_transformation_matrix")};
-                    glUniformMatrix4fv(
-                        texture2_transformation_matrix_uniform_location,
-                        1, GL_FALSE,
-                        glm::value_ptr(_texture2->get_transformation_matrix())
-                    );
+                    _shader->set_uniform(_shader_variant->texture2_sampler, 1);
+                    _shader->set_uniform(_shader_variant->texturing_mode2, static_cast<GLint>(_texture2->get_mode()));
+                    _shader->set_uniform(_shader_variant->texture2_transformation_enabled, static_cast<GLint>(_texture2->is_transformation_enabled()));
+                    _shader->set_uniform(_shader_variant->texture2_transformation_matrix, _texture2->get_transformation_matrix());
                 }
+            } else {
+                _shader->set_uniform(_shader_variant->texture2_enabled, 0);
             }
 
             if (_texture1_normals) {
                 _texture1_normals->update(2);
 
-                int texture1_normals_enabled_uniform_location{_shader->get_uniforms().at("texture1_normals_enabled")};
-                glUniform1i(
-                    texture1_normals_enabled_uniform_location,
-                    static_cast<GLint>(_texture1_normals->is_enabled())
-                );
+                _shader->set_uniform(_shader_variant->texture1_normals_enabled, static_cast<GLint>(_texture1_normals->is_enabled()));
 
                 if (_texture1_normals->is_enabled()) {
-                    int texture1_normals_sampler_uniform_location{_shader->get_uniforms().at("texture1_normals_sampler")};
-                    glUniform1i(texture1_normals_sampler_uniform_location, 2);
+                    _shader->set_uniform(_shader_variant->texture1_normals_sampler, 2);
                 }
+            } else {
+                _shader->set_uniform(_shader_variant->texture1_normals_enabled, 0);
             }
 
-            int fog_enabled_uniform_location{_shader->get_uniforms().at("fog_enabled")};
-            glUniform1i(fog_enabled_uniform_location, static_cast<GLint>(_fog_enabled));
-
-            int fog_type_uniform_location{_shader->get_uniforms().at("fog_type")};
-            glUniform1i(fog_type_uniform_location, static_cast<GLint>(_fog_type));
+            _shader->set_uniform(_shader_variant->fog_enabled, static_cast<GLint>(_fog_enabled));
+            _shader->set_uniform(_shader_variant->fog_type, static_cast<GLint>(_fog_type));
+            _shader->set_uniform(_shader_variant->fog_depth, static_cast<GLint>(_fog_depth));
+            _shader->set_uniform(_shader_variant->fog_color, _fog_color);
+            _shader->set_uniform(_shader_variant->fog_far_minus_near_plane, _fog_far_plane - _fog_near_plane);
+            _shader->set_uniform(_shader_variant->fog_far_plane, _fog_far_plane);
+            _shader->set_uniform(_shader_variant->fog_density, _fog_density);
+        }
 
-            int fog_depth_uniform_location{_shader->get_uniforms().at("fog_depth")};
-            glUniform1i(fog_depth_uniform_location, static_cast<GLint>(_fog_depth));
+        struct DirectionalLightUniforms
+        {
+            Shader::Uniform enabled;
+            Shader::Uniform two_sided;
+            Shader::Uniform view_direction;
+            Shader::Uniform ambient_color;
+            Shader::Uniform diffuse_color;
+            Shader::Uniform specular_color;
+            Shader::Uniform intensity;
+        };
+
+        struct PointLightUniforms
+        {
+            Shader::Uniform enabled;
+            Shader::Uniform two_sided;
+            Shader::Uniform view_position;
+            Shader::Uniform ambient_color;
+            Shader::Uniform diffuse_color;
+            Shader::Uniform specular_color;
+            Shader::Uniform intensity;
+            Shader::Uniform constant_attenuation;
+            Shader::Uniform linear_attenuation;
+            Shader::Uniform quadratic_attenuation;
+        };
+
+        struct SpotLightUniforms
+        {
+            Shader::Uniform enabled;
+            Shader::Uniform two_sided;
+            Shader::Uniform view_position;
+            Shader::Uniform view_direction;
+            Shader::Uniform ambient_color;
+            Shader::Uniform diffuse_color;
+            Shader::Uniform specular_color;
+            Shader::Uniform exponent;
+            Shader::Uniform cutoff_angle_cosine;
+            Shader::Uniform intensity;
+            Shader::Uniform constant_attenuation;
+            Shader::Uniform linear_attenuation;
+            Shader::Uniform quadratic_attenuation;
+        };
+
+        struct ShaderVariant
+        {
+            std::shared_ptr<Shader> shader;
+            InstanceInputs instance_inputs;
+
+            Shader::Uniform model_view_matrix;
+            Shader::Uniform view_matrix;
+            Shader::Uniform projection_matrix;
+            Shader::Uniform normal_matrix;
+            Shader::Uniform point_size;
+            Shader::Uniform instance_color;
+            Shader::Uniform ambient_light_color;
+            Shader::Uniform material_ambient_color;
+            Shader::Uniform material_diffuse_color;
+            Shader::Uniform material_emission_color;
+            Shader::Uniform material_specular_color;
+            Shader::Uniform material_specular_exponent;
+            Shader::Uniform texture1_sampler;
+            Shader::Uniform texture1_enabled;
+            Shader::Uniform texture1_transformation_enabled;
+            Shader::Uniform texture1_transformation_matrix;
+            Shader::Uniform texturing_mode1;
+            Shader::Uniform texture1_normals_sampler;
+            Shader::Uniform texture1_normals_enabled;
+            Shader::Uniform texture2_sampler;
+            Shader::Uniform texture2_enabled;
+            Shader::Uniform texture2_transformation_enabled;
+            Shader::Uniform texture2_transformation_matrix;
+            Shader::Uniform texturing_mode2;
+            Shader::Uniform fog_enabled;
+            Shader::Uniform fog_type;
+            Shader::Uniform fog_depth;
+            Shader::Uniform fog_color;
+            Shader::Uniform fog_far_minus_near_plane;
+            Shader::Uniform fog_far_plane;
+            Shader::Uniform fog_density;
+
+            std::vector<DirectionalLightUniforms> directional_light_uniforms;
+            std::vector<PointLightUniforms> point_light_uniforms;
+            std::vector<SpotLightUniforms> spot_light_uniforms;
+        };
 
-            int fog_color_uniform_location{_shader->get_uniforms().at("fog_color")};
-            glUniform3fv(
-                fog_color_uniform_location,
-                1, glm::value_ptr(_fog_color)
-            );
+        static std::string _uniform_at_index(const std::string &uniform, size_t slot)
+        {
+            return uniform + "[" + std::to_string(slot) + "]";
+        }
 
-            int fog_far_minus_near_plane_uniform_location{_shader->get_uniforms().at("fog_far_minus_near_plane")};
-            glUniform1f(fog_far_minus_near_plane_uniform_location, _fog_far_plane - _fog_near_plane);
+        static void _add_uniforms(ShaderVariant &shader_variant, size_t directional_light_count, size_t point_light_count, size_t spot_light_count)
+        {
+            shader_variant.model_view_matrix = shader_variant.shader->add_uniform("model_view_matrix");
+            shader_variant.view_matrix = shader_variant.shader->add_uniform("view_matrix");
+            shader_variant.projection_matrix = shader_variant.shader->add_uniform("projection_matrix");
+            shader_variant.normal_matrix = shader_variant.shader->add_uniform("normal_matrix");
+            shader_variant.point_size = shader_variant.shader->add_uniform("point_size");
+            shader_variant.instance_color = shader_variant.shader->add_uniform("instance_color");
+            shader_variant.instance_inputs = _resolve_instance_inputs(*shader_variant.shader);
+
+            shader_variant.ambient_light_color = shader_variant.shader->add_uniform("ambient_light_color");
+
+            shader_variant.material_ambient_color = shader_variant.shader->add_uniform("material_ambient_color");
+            shader_variant.material_diffuse_color = shader_variant.shader->add_uniform("material_diffuse_color");
+            shader_variant.material_emission_color = shader_variant.shader->add_uniform("material_emission_color");
+            shader_variant.material_specular_color = shader_variant.shader->add_uniform("material_specular_color");
+            shader_variant.material_specular_exponent = shader_variant.shader->add_uniform("material_specular_exponent");
+
+            shader_variant.texture1_sampler = shader_variant.shader->add_uniform("texture1_sampler");
+            shader_variant.texture1_enabled = shader_variant.shader->add_uniform("texture1_enabled");
+            shader_variant.texture1_transformation_enabled = shader_variant.shader->add_uniform("texture1_transformation_enabled");
+            shader_variant.texture1_transformation_matrix = shader_variant.shader->add_uniform("texture1_transformation_matrix");
+            shader_variant.texturing_mode1 = shader_variant.shader->add_uniform("texturing_mode1");
+            shader_variant.texture1_normals_sampler = shader_variant.shader->add_uniform("texture1_normals_sampler");
+            shader_variant.texture1_normals_enabled = shader_variant.shader->add_uniform("texture1_normals_enabled");
+
+            shader_variant.texture2_sampler = shader_variant.shader->add_uniform("texture2_sampler");
+            shader_variant.texture2_enabled = shader_variant.shader->add_uniform("texture2_enabled");
+            shader_variant.texture2_transformation_enabled = shader_variant.shader->add_uniform("texture2_transformation_enabled");
+            shader_variant.texture2_transformation_matrix = shader_variant.shader->add_uniform("texture2_transformation_matrix");
+            shader_variant.texturing_mode2 = shader_variant.shader->add_uniform("texturing_mode2");
+
+            shader_variant.fog_enabled = shader_variant.shader->add_uniform("fog_enabled");
+            shader_variant.fog_type = shader_variant.shader->add_uniform("fog_type");
+            shader_variant.fog_depth = shader_variant.shader->add_uniform("fog_depth");
+            shader_variant.fog_color = shader_variant.shader->add_uniform("fog_color");
+            shader_variant.fog_far_minus_near_plane = shader_variant.shader->add_uniform("fog_far_minus_near_plane");
+            shader_variant.fog_far_plane = shader_variant.shader->add_uniform("fog_far_plane");
+            shader_variant.fog_density = shader_variant.shader->add_uniform("fog_density");
+
+            for (size_t i = 0; i < directional_light_count; ++i) {
+                DirectionalLightUniforms directional_light_uniforms;
+                directional_light_uniforms.enabled = shader_variant.shader->add_uniform(_uniform_at_index("directional_light_enabled", i));
+                directional_light_uniforms.two_sided = shader_variant.shader->add_uniform(_uniform_at_index("directional_light_two_sided", i));
+                directional_light_uniforms.view_direction = shader_variant.shader->add_uniform(_uniform_at_index("directional_light_view_direction", i));
+                directional_light_uniforms.ambient_color = shader_variant.shader->add_uniform(_uniform_at_index("directional_light_ambient_color", i));
+                directional_light_uniforms.diffuse_color = shader_variant.shader->add_uniform(_uniform_at_index("directional_light_diffuse_color", i));
+                directional_light_uniforms.specular_color = shader_variant.shader->add_uniform(_uniform_at_index("directional_light_specular_color", i));
+                directional_light_uniforms.intensity = shader_variant.shader->add_uniform(_uniform_at_index("directional_light_intensity", i));
+                shader_variant.directional_light_uniforms.push_back(directional_light_uniforms);
+            }
 
-            int fog_far_plane_uniform_location{_shader->get_uniforms().at("fog_far_plane")};
-            glUniform1f(fog_far_plane_uniform_location, _fog_far_plane);
+            for (size_t i = 0; i < point_light_count; ++i) {
+                PointLightUniforms point_light_uniforms;
+                point_light_uniforms.enabled = shader_variant.shader->add_uniform(_uniform_at_index("point_light_enabled", i));
+                point_light_uniforms.two_sided = shader_variant.shader->add_uniform(_uniform_at_index("point_light_two_sided", i));
+                point_light_uniforms.view_position = shader_variant.shader->add_uniform(_uniform_at_index("point_light_view_position", i));
+                point_light_uniforms.ambient_color = shader_variant.shader->add_uniform(_uniform_at_index("point_light_ambient_color", i));
+                point_light_uniforms.diffuse_color = shader_variant.shader->add_uniform(_uniform_at_index("point_light_diffuse_color", i));
+                point_light_uniforms.specular_color = shader_variant.shader->add_uniform(_uniform_at_index("point_light_specular_color", i));
+                point_light_uniforms.intensity = shader_variant.shader->add_uniform(_uniform_at_index("point_light_intensity", i));
+                point_light_uniforms.constant_attenuation = shader_variant.shader->add_uniform(_uniform_at_index("point_light_constant_attenuation", i));
+                point_light_uniforms.linear_attenuation = shader_variant.shader->add_uniform(_uniform_at_index("point_light_linear_attenuation", i));
+                point_light_uniforms.quadratic_attenuation = shader_variant.shader->add_uniform(_uniform_at_index("point_light_quadratic_attenuation", i));
+                shader_variant.point_light_uniforms.push_back(point_light_uniforms);
+            }
 
-            int fog_density_uniform_location{_shader->get_uniforms().at("fog_density")};
-            glUniform1f(fog_density_uniform_location, _fog_density);
+            for (size_t i = 0; i < spot_light_count; ++i) {
+                SpotLightUniforms spot_light_uniforms;
+                spot_light_uniforms.enabled = shader_variant.shader->add_uniform(_uniform_at_index("spot_light_enabled", i));
+                spot_light_uniforms.two_sided = shader_variant.shader->add_uniform(_uniform_at_index("spot_light_two_sided", i));
+                spot_light_uniforms.view_position = shader_variant.shader->add_uniform(_uniform_at_index("spot_light_view_position", i));
+                spot_light_uniforms.view_direction = shader_variant.shader->add_uniform(_uniform_at_index("spot_light_view_direction", i));
+                spot_light_uniforms.ambient_color = shader_variant.shader->add_uniform(_uniform_at_index("spot_light_ambient_color", i));
+                spot_light_uniforms.diffuse_color = shader_variant.shader->add_uniform(_uniform_at_index("spot_light_diffuse_color", i));
+                spot_light_uniforms.specular_color = shader_variant.shader->add_uniform(_uniform_at_index("spot_light_specular_color", i));
+                spot_light_uniforms.exponent = shader_variant.shader->add_uniform(_uniform_at_index("spot_light_exponent", i));
+                spot_light_uniforms.cutoff_angle_cosine = shader_variant.shader->add_uniform(_uniform_at_index("spot_light_cutoff_angle_cosine", i));
+                spot_light_uniforms.intensity = shader_variant.shader->add_uniform(_uniform_at_index("spot_light_intensity", i));
+                spot_light_uniforms.constant_attenuation = shader_variant.shader->add_uniform(_uniform_at_index("spot_light_constant_attenuation", i));
+                spot_light_uniforms.linear_attenuation = shader_variant.shader->add_uniform(_uniform_at_index("spot_light_linear_attenuation", i));
+                spot_light_uniforms.quadratic_attenuation = shader_variant.shader->add_uniform(_uniform_at_index("spot_light_quadratic_attenuation", i));
+                shader_variant.spot_light_uniforms.push_back(spot_light_uniforms);
+            }
         }
 
-        void use() final
+        void _update_frame_uniforms(const FrameUniforms &frame_uniforms)
         {
-            _shader->use();
+            _shader->set_uniform(_shader_variant->ambient_light_color, frame_uniforms.get_ambient_light_color());
 
-            if (_texture1) {
-                _texture1->use(0);
+            const auto &directional_lights = frame_uniforms.get_directional_lights();
+            for (std::vector<FrameUniforms::DirectionalLightData>::size_type i = 0; i < directional_lights.size(); ++i) {
+                const auto &directional_light = directional_lights[i];
+                const auto &directional_light_uniforms = _shader_variant->directional_light_uniforms[i];
+
+                _shader->set_uniform(directional_light_uniforms.enabled, directional_light.enabled);
+                _shader->set_uniform(directional_light_uniforms.two_sided, directional_light.two_sided);
+                _shader->set_uniform(directional_light_uniforms.view_direction, directional_light.view_direction);
+                _shader->set_uniform(directional_light_uniforms.ambient_color, directional_light.ambient_color);
+                _shader->set_uniform(directional_light_uniforms.diffuse_color, directional_light.diffuse_color);
+                _shader->set_uniform(directional_light_uniforms.specular_color, directional_light.specular_color);
+                _shader->set_uniform(directional_light_uniforms.intensity, directional_light.intensity);
             }
-            if (_texture2) {
-                _texture2->use(1);
+
+            const auto &point_lights = frame_uniforms.get_point_lights();
+            for (std::vector<FrameUniforms::PointLightData>::size_type i = 0; i < point_lights.size(); ++i) {
+                const auto &point_light = point_lights[i];
+                const auto &point_light_uniforms = _shader_variant->point_light_uniforms[i];
+
+                _shader->set_uniform(point_light_uniforms.enabled, point_light.enabled);
+                _shader->set_uniform(point_light_uniforms.two_sided, point_light.two_sided);
+                _shader->set_uniform(point_light_uniforms.view_position, point_light.view_position);
+                _shader->set_uniform(point_light_uniforms.ambient_color, point_light.ambient_color);
+                _shader->set_uniform(point_light_uniforms.diffuse_color, point_light.diffuse_color);
+                _shader->set_uniform(point_light_uniforms.specular_color, point_light.specular_color);
+                _shader->set_uniform(point_light_uniforms.intensity, point_light.intensity);
+                _shader->set_uniform(point_light_uniforms.constant_attenuation, point_light.constant_attenuation);
+                _shader->set_uniform(point_light_uniforms.linear_attenuation, point_light.linear_attenuation);
+                _shader->set_uniform(point_light_uniforms.quadratic_attenuation, point_light.quadratic_attenuation);
             }
-            if (_texture1_normals) {
-                _texture1_normals->use(2);
+
+            const auto &spot_lights = frame_uniforms.get_spot_lights();
+            for (std::vector<FrameUniforms::SpotLightData>::size_type i = 0; i < spot_lights.size(); ++i) {
+                const auto &spot_light = spot_lights[i];
+                const auto &spot_light_uniforms = _shader_variant->spot_light_uniforms[i];
+
+                _shader->set_uniform(spot_light_uniforms.enabled, spot_light.enabled);
+                _shader->set_uniform(spot_light_uniforms.two_sided, spot_light.two_sided);
+                _shader->set_uniform(spot_light_uniforms.view_position, spot_light.view_position);
+                _shader->set_uniform(spot_light_uniforms.view_direction, spot_light.view_direction);
+                _shader->set_uniform(spot_light_uniforms.ambient_color, spot_light.ambient_color);
+                _shader->set_uniform(spot_light_uniforms.diffuse_color, spot_light.diffuse_color);
+                _shader->set_uniform(spot_light_uniforms.specular_color, spot_light.specular_color);
+                _shader->set_uniform(spot_light_uniforms.exponent, spot_light.exponent);
+                _shader->set_uniform(spot_light_uniforms.cutoff_angle_cosine, spot_light.cutoff_angle_cosine);
+                _shader->set_uniform(spot_light_uniforms.intensity, spot_light.intensity);
+                _shader->set_uniform(spot_light_uniforms.constant_attenuation, spot_light.constant_attenuation);
+                _shader->set_uniform(spot_light_uniforms.linear_attenuation, spot_light.linear_attenuation);
+                _shader->set_uniform(spot_light_uniforms.quadratic_attenuation, spot_light.quadratic_attenuation);
             }
-        }
 
-    private:
-        static std::string _uniform_at_index(const std::string &uniform, size_t slot)
-        {
-            return uniform + "[" + std::to_string(slot) + "]";
+            _shader->set_frame_uniforms_frame(frame_uniforms.get_frame());
         }
 
-        void _update_light_uniforms_if_necessary(const std::shared_ptr<Scene> &scene)
+        ShaderVariant &_get_shader_variant(
+            size_t directional_light_count, size_t point_light_count, size_t spot_light_count,
+            bool instanced, InstancingMode instancing_mode
+        )
         {
-            auto directional_light_count = scene->get_directional_lights().size();
-            auto point_light_count = scene->get_point_lights().size();
-            auto spot_light_count = scene->get_spot_lights().size();
+            // The instancing mode only matters for instanced variants.
+            if (!instanced) {
+                instancing_mode = InstanceAttributes;
+            }
 
-            if (_previous_directional_light_count != directional_light_count ||
-                _previous_point_light_count != point_light_count ||
-                _previous_spot_light_count != spot_light_count) {
-                std::vector<std::string> uniforms{
-                    "model_view_matrix",
-                    "projection_matrix",
-                    "normal_matrix",
-                    "point_size",
-
-                    "ambient_light_color",
-
-                    "material_ambient_color",
-                    "material_diffuse_color",
-                    "material_emission_color",
-                    "material_specular_color",
-                    "material_specular_exponent",
-
-                    "texture1_sampler",
-                    "texture1_enabled",
-                    "texture1_transformation_enabled",
-                    "texture1_transformation_matrix",
-                    "texturing_mode1",
-                    "texture1_normals_sampler",
-                    "texture1_normals_enabled",
-
-                    "texture2_sampler",
-                    "texture2_enabled",
-                    "texture2_transformation_enabled",
-                    "texture2_transformation_matrix",
-                    "texturing_mode2",
-
-                    "fog_enabled",
-                    "fog_type",
-                    "fog_depth",
-                    "fog_color",
-                    "fog_far_minus_near_plane",
-                    "fog_far_plane",
-                    "fog_density"
-                };
-
-                std::vector<std::string> directional_light_uniforms{
-                    "directional_light_enabled",
-                    "directional_light_two_sided",
-                    "directional_light_view_direction",
-                    "directional_light_ambient_color",
-                    "directional_light_diffuse_color",
-                    "directional_light_specular_color",
-                    "directional_light_intensity"
-                };
-
-                std::vector<std::string> point_light_uniforms{
-                    "point_light_enabled",
-                    "point_light_two_sided",
-                    "point_light_view_position",
-                    "point_light_ambient_color",
-                    "point_light_diffuse_color",
-                    "point_light_specular_color",
-                    "point_light_intensity",
-                    "point_light_constant_attenuation",
-                    "point_light_linear_attenuation",
-                    "point_light_quadratic_attenuation"
-                };
-
-                std::vector<std::string> spot_light_uniforms{
-                    "spot_light_enabled",
-                    "spot_light_two_sided",
-                    "spot_light_view_position",
-                    "spot_light_view_direction",
-                    "spot_light_ambient_color",
-                    "spot_light_diffuse_color",
-                    "spot_light_specular_color",
-                    "spot_light_exponent",
-                    "spot_light_cutoff_angle_cosine",
-                    "spot_light_intensity",
-                    "spot_light_constant_attenuation",
-                    "spot_light_linear_attenuation",
-                    "spot_light_quadratic_attenuation"
-                };
-
-                auto &uniform_map = _shader->get_uniforms();
-                uniform_map.clear();
-
-                for (const auto &uniform : uniforms) {
-                    uniform_map[uniform] = -1;
-                }
-                for (const auto &uniform : directional_light_uniforms) {
-                    for (size_t i = 0; i < directional_light_count; ++i) {
-                        uniform_map[_uniform_at_index(uniform, i)] = -1;
-                    }
-                }
-                for (const auto &uniform : point_light_uniforms) {
-                    for (size_t i = 0; i < point_light_count; ++i) {
-                        uniform_map[_uniform_at_index(uniform, i)] = -1;
-                    }
-                }
-                for (const auto &uniform : spot_light_uniforms) {
-                    for (size_t i = 0; i < spot_light_count; ++i) {
-                        uniform_map[_uniform_at_index(uniform, i)] = -1;
-                    }
+            auto &shader_variant = _shader_variants[std::make_tuple(directional_light_count, point_light_count, spot_light_count, instanced, instancing_mode)];
+            if (!shader_variant.shader) {
+                std::vector<std::string> attributes{_shader_attributes};
+                std::string instancing_defines;
+                if (instanced && instancing_mode == InstanceUniformArrays) {
+                    attributes.emplace_back("instance_index");
+                    instancing_defines =
+                        "#define INSTANCING\n"
+                        "#define INSTANCE_ARRAY_SIZE " + std::to_string(InstanceUniformArraySize) + "\n";
+                } else if (instanced) {
+                    attributes.insert(attributes.end(), _instance_attributes.begin(), _instance_attributes.end());
+                    instancing_defines = "#define INSTANCING\n";
                 }
 
-                _shader->set_fragment_shader_source(
+                shader_variant.shader = ES2ShaderRegistry::get_instance().get_shader(
+                    _vertex_shader_source, _fragment_shader_source, attributes, {},
+                    instancing_defines +
                     "#define DIRECTIONAL_LIGHT_COUNT " + std::to_string(directional_light_count) + "\n" +
                     "#define POINT_LIGHT_COUNT "       + std::to_string(point_light_count)       + "\n" +
-                    "#define SPOT_LIGHT_COUNT "        + std::to_string(spot_light_count)        + "\n\n" +
-                    _fragment_shader_source
+                    "#define SPOT_LIGHT_COUNT "        + std::to_string(spot_light_count)        + "\n\n"
+                );
+                _add_uniforms(shader_variant, directional_light_count, point_light_count, spot_light_count);
+            }
+
+            return shader_variant;
+        }
+
+        void _use_shader_variant(
+            size_t directional_light_count, size_t point_light_count, size_t spot_light_count,
+            bool instanced, InstancingMode instancing_mode
+        )
+        {
+            _shader_variant = &_get_shader_variant(
+                directional_light_count, point_light_count, spot_light_count, instanced, instancing_mode
+            );
+            _shader = _shader_variant->shader;
+        }
+
+        void _update_shader_variant_if_necessary(
+            const FrameUniforms &frame_uniforms, bool instanced, InstancingMode instancing_mode
+        )
+        {
+            auto directional_light_count = frame_uniforms.get_directional_lights().size();
+            auto point_light_count = frame_uniforms.get_point_lights().size();
+            auto spot_light_count = frame_uniforms.get_spot_lights().size();
+
+            if (_previous_directional_light_count != directional_light_count ||
+                _previous_point_light_count != point_light_count ||
+                _previous_spot_light_count != spot_light_count ||
+                _previous_instanced != instanced ||
+                _previous_instancing_mode != instancing_mode) {
+                _use_shader_variant(
+                    directional_light_count, point_light_count, spot_light_count, instanced, instancing_mode
                 );
-                _shader->compile();
 
                 _previous_directional_light_count = directional_light_count;
                 _previous_point_light_count = point_light_count;
                 _previous_spot_light_count = spot_light_count;
+                _previous_instanced = instanced;
+                _previous_instancing_mode = instancing_mode;
             }
         }
 
@@ -732,12 +642,33 @@ namespace asr
             return GL_CW;
         }
 
+        std::vector<std::string> _shader_attributes{
+            "position",
+            "color",
+            "normal",
+            "tangent",
+            "binormal",
+            "texture1_coordinates",
+            "texture2_coordinates"
+        };
+        std::vector<std::string> _instance_attributes{
+            "instance_model_matrix_column0",
+            "instance_model_matrix_column1",
+            "instance_model_matrix_column2",
+            "instance_model_matrix_column3",
+            "instance_color"
+        };
         std::string _vertex_shader_source;
         std::string _fragment_shader_source;
 
         size_t _previous_directional_light_count{1};
         size_t _previous_point_light_count{1};
         size_t _previous_spot_light_count{0};
+        bool _previous_instanced{false};
+        InstancingMode _previous_instancing_mode{InstanceAttributes};
+
+        std::map<std::tuple<size_t, size_t, size_t, bool, InstancingMode>, ShaderVariant> _shader_variants;
+        ShaderVariant *_shader_variant{nullptr};
     };
 }
 
@@ -2,12 +2,19 @@
 #define MATERIAL_H
 
 #include "renderer/shader.h"
+#include "renderer/frame_uniforms.h"
 #include "scene/scene.h"
 #include "objects/mesh.h"
+#include "textures/texture.h"
 
 #include <glm/glm.hpp>
 
+#include <array>
 #include <memory>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cstddef>
 
 namespace asr
 {
@@ -80,6 +87,36 @@ namespace asr
             Radial
         };
 
+        // Where instanced shaders read the per-instance matrices and colours from.
+        enum InstancingMode
+        {
+            InstanceAttributes,
+            InstanceUniformArrays
+        };
+
+        // Instances per draw call with InstanceUniformArrays. Their matrices and colours take 80 of the 128 vertex
+        // uniform vectors ES2 guarantees.
+        static constexpr size_t InstanceUniformArraySize{16};
+
+        // Handles of an instanced shader's per-instance inputs, resolved once when the shader variant is created.
+        struct InstanceInputs
+        {
+            std::array<Shader::Attribute, 4> model_matrix_columns;
+            Shader::Attribute color;
+            Shader::Attribute index;
+            Shader::Attribute vertex_color;
+            Shader::Uniform model_matrices;
+            Shader::Uniform colors;
+        };
+
+        class Listener
+        {
+        public:
+            virtual ~Listener() = default;
+
+            virtual void on_material_changed(Material &material) = 0;
+        };
+
         [[nodiscard]] const std::shared_ptr<Shader> &get_shader() const
         {
             return _shader;
@@ -87,6 +124,22 @@ namespace asr
 
         virtual ~Material() = default;
 
+        void add_listener(const std::shared_ptr<Listener> &listener)
+        {
+            _listeners.push_back(listener);
+        }
+
+        void remove_listener(const std::shared_ptr<Listener> &listener)
+        {
+            _listeners.erase(
+                std::remove_if(std::begin(_listeners), std::end(_listeners), [&](const auto &other) {
+                    auto other_listener = other.lock();
+                    return !other_listener || other_listener == listener;
+                }),
+                std::end(_listeners)
+            );
+        }
+
         [[nodiscard]] float get_line_width() const
         {
             return _line_width;
@@ -384,7 +437,10 @@ namespace asr
 
         void set_transparent(bool transparent)
         {
-            _transparent = transparent;
+            if (_transparent != transparent) {
+                _transparent = transparent;
+                _notify_listeners();
+            }
         }
 
         [[nodiscard]] bool is_overlay() const
@@ -394,7 +450,10 @@ namespace asr
 
         void set_overlay(bool overlay)
         {
-            _overlay = overlay;
+            if (_overlay != overlay) {
+                _overlay = overlay;
+                _notify_listeners();
+            }
         }
 
         [[nodiscard]] int get_overlay_priority() const
@@ -407,13 +466,67 @@ namespace asr
             _overlay_priority = overlay_priority;
         }
 
-        virtual void update(std::shared_ptr<Scene> scene, std::shared_ptr<Mesh> mesh) = 0;
+        [[nodiscard]] bool is_ready() const
+        {
+            return _shader && _shader->is_compiled();
+        }
+
+        virtual void update(const FrameUniforms &frame_uniforms, const std::shared_ptr<Mesh> &mesh) = 0;
+
+        [[nodiscard]] virtual bool is_instancing_supported() const
+        {
+            return false;
+        }
+
+        virtual void update_instanced(const FrameUniforms &, InstancingMode)
+        {}
+
+        // The inputs of the shader selected by the last update_instanced call.
+        [[nodiscard]] virtual const InstanceInputs &get_instance_inputs() const
+        {
+            static const InstanceInputs instance_inputs;
+
+            return instance_inputs;
+        }
+
+        [[nodiscard]] virtual const Texture *get_primary_texture() const
+        {
+            return nullptr;
+        }
+
+        // The texture sampled with the second set of texture coordinates.
+        [[nodiscard]] virtual const Texture *get_secondary_texture() const
+        {
+            return nullptr;
+        }
+
+        /* Whether meshes with the other material can be merged into one draw with this one. Texture transformations
+         * may differ, as the sprite batcher bakes them into the texture coordinates. */
+        [[nodiscard]] virtual bool is_batchable_with(const Material &other) const
+        {
+            return this == &other;
+        }
 
         virtual void use() = 0;
 
     protected:
         std::shared_ptr<Shader> _shader;
 
+        static InstanceInputs _resolve_instance_inputs(Shader &shader)
+        {
+            InstanceInputs instance_inputs;
+            for (size_t i = 0; i < instance_inputs.model_matrix_columns.size(); ++i) {
+                instance_inputs.model_matrix_columns[i] = shader.get_attribute("instance_model_matrix_column" + std::to_string(i));
+            }
+            instance_inputs.color = shader.get_attribute("instance_color");
+            instance_inputs.index = shader.get_attribute("instance_index");
+            instance_inputs.vertex_color = shader.get_attribute("color");
+            instance_inputs.model_matrices = shader.add_uniform("instance_model_matrices");
+            instance_inputs.colors = shader.add_uniform("instance_colors");
+
+            return instance_inputs;
+        }
+
         float _line_width{1.0f};
         bool _prefer_line_width_from_geometry{false};
 
@@ -454,6 +567,52 @@ namespace asr
         bool _transparent{false};
         bool _overlay{false};
         int _overlay_priority{0};
+
+        std::vector<std::weak_ptr<Listener>> _listeners;
+
+        [[nodiscard]] bool _has_same_render_state_as(const Material &other) const
+        {
+            return _line_width == other._line_width &&
+                   _prefer_line_width_from_geometry == other._prefer_line_width_from_geometry &&
+                   _point_sizing_enabled == other._point_sizing_enabled &&
+                   _point_size == other._point_size &&
+                   _prefer_point_size_from_geometry == other._prefer_point_size_from_geometry &&
+                   _depth_mask_enabled == other._depth_mask_enabled &&
+                   _depth_test_enabled == other._depth_test_enabled &&
+                   _depth_test_function == other._depth_test_function &&
+                   _blending_enabled == other._blending_enabled &&
+                   _color_blending_equation == other._color_blending_equation &&
+                   _alpha_blending_equation == other._alpha_blending_equation &&
+                   _source_color_blending_function == other._source_color_blending_function &&
+                   _source_alpha_blending_function == other._source_alpha_blending_function &&
+                   _destination_color_blending_function == other._destination_color_blending_function &&
+                   _destination_alpha_blending_function == other._destination_alpha_blending_function &&
+                   _blending_constant_color == other._blending_constant_color &&
+                   _face_culling_enabled == other._face_culling_enabled &&
+                   _cull_face_mode == other._cull_face_mode &&
+                   _front_face_order == other._front_face_order &&
+                   _polygon_offset_enabled == other._polygon_offset_enabled &&
+                   _polygon_offset_factor == other._polygon_offset_factor &&
+                   _polygon_offset_units == other._polygon_offset_units &&
+                   _fog_enabled == other._fog_enabled &&
+                   _fog_type == other._fog_type &&
+                   _fog_depth == other._fog_depth &&
+                   _fog_color == other._fog_color &&
+                   _fog_near_plane == other._fog_near_plane &&
+                   _fog_far_plane == other._fog_far_plane &&
+                   _fog_density == other._fog_density &&
+                   _transparent == other._transparent &&
+                   _overlay == other._overlay;
+        }
+
+        void _notify_listeners()
+        {
+            for (const auto &listener : _listeners) {
+                if (auto locked_listener = listener.lock()) {
+                    locked_listener->on_material_changed(*this);
+                }
+            }
+        }
     };
 }
 
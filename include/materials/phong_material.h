@@ -91,6 +91,16 @@ namespace asr
             _texture2 = texture_2;
         }
 
+        [[nodiscard]] const Texture *get_primary_texture() const override
+        {
+            return _texture1.get();
+        }
+
+        [[nodiscard]] const Texture *get_secondary_texture() const override
+        {
+            return _texture2.get();
+        }
+
     protected:
         glm::vec3 _ambient_color{0.0f};
         glm::vec4 _diffuse_color{1.0f};
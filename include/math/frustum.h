@@ -0,0 +1,111 @@
+#ifndef FRUSTUM_H
+#define FRUSTUM_H
+
+#include "math/plane.h"
+#include "math/aabb.h"
+#include "math/sphere.h"
+
+#include <glm/glm.hpp>
+
+#include <array>
+
+namespace asr
+{
+    class Frustum
+    {
+    public:
+        Frustum() = default;
+
+        explicit Frustum(const glm::mat4 &view_projection_matrix)
+        {
+            set_from_matrix(view_projection_matrix);
+        }
+
+        [[nodiscard]] const std::array<Plane, 6> &get_planes() const
+        {
+            return _planes;
+        }
+
+        void set_from_matrix(const glm::mat4 &view_projection_matrix)
+        {
+            glm::vec4 row_x{view_projection_matrix[0][0], view_projection_matrix[1][0], view_projection_matrix[2][0], view_projection_matrix[3][0]};
+            glm::vec4 row_y{view_projection_matrix[0][1], view_projection_matrix[1][1], view_projection_matrix[2][1], view_projection_matrix[3][1]};
+            glm::vec4 row_z{view_projection_matrix[0][2], view_projection_matrix[1][2], view_projection_matrix[2][2], view_projection_matrix[3][2]};
+            glm::vec4 row_w{view_projection_matrix[0][3], view_projection_matrix[1][3], view_projection_matrix[2][3], view_projection_matrix[3][3]};
+
+            _planes[0] = _make_plane(row_w + row_x);
+            _planes[1] = _make_plane(row_w - row_x);
+            _planes[2] = _make_plane(row_w + row_y);
+            _planes[3] = _make_plane(row_w - row_y);
+            _planes[4] = _make_plane(row_w + row_z);
+            _planes[5] = _make_plane(row_w - row_z);
+        }
+
+        [[nodiscard]] bool intersects_sphere(const Sphere &sphere) const
+        {
+            for (const auto &plane : _planes) {
+                if (plane.get_distance_to_point(sphere.get_center()) < -sphere.get_radius()) {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+        [[nodiscard]] bool intersects_box(const AABB &box) const
+        {
+            const auto &minimum = box.get_minimum();
+            const auto &maximum = box.get_maximum();
+
+            for (const auto &plane : _planes) {
+                const auto &normal = plane.get_normal();
+                glm::vec3 positive_vertex{
+                    normal.x >= 0.0f ? maximum.x : minimum.x,
+                    normal.y >= 0.0f ? maximum.y : minimum.y,
+                    normal.z >= 0.0f ? maximum.z : minimum.z
+                };
+                if (plane.get_distance_to_point(positive_vertex) < 0.0f) {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+        [[nodiscard]] bool contains_box(const AABB &box) const
+        {
+            const auto &minimum = box.get_minimum();
+            const auto &maximum = box.get_maximum();
+
+            for (const auto &plane : _planes) {
+                const auto &normal = plane.get_normal();
+                glm::vec3 negative_vertex{
+                    normal.x >= 0.0f ? minimum.x : maximum.x,
+                    normal.y >= 0.0f ? minimum.y : maximum.y,
+                    normal.z >= 0.0f ? minimum.z : maximum.z
+                };
+                if (plane.get_distance_to_point(negative_vertex) < 0.0f) {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+    private:
+        std::array<Plane, 6> _planes;
+
+        static Plane _make_plane(const glm::vec4 &coefficients)
+        {
+            glm::vec3 normal{coefficients};
+            float length = glm::length(normal);
+            if (length == 0.0f) {
+                return Plane{glm::vec3{0.0f}, 0.0f};
+            }
+
+            return Plane{normal / length, coefficients.w / length};
+        }
+    };
+}
+
+#endif
@@ -9,6 +9,8 @@ namespace asr
     class Plane
     {
     public:
+        Plane() = default;
+
         Plane(const glm::vec3 &normal, float distance) : _normal(normal), _distance(distance)
         {}
 
@@ -22,6 +24,11 @@ namespace asr
             return _distance;
         }
 
+        [[nodiscard]] float get_distance_to_point(const glm::vec3 &point) const
+        {
+            return glm::dot(_normal, point) + _distance;
+        }
+
         void transform(glm::mat4 transformation_matrix)
         {
             glm::mat3 normal_matrix = glm::inverseTranspose(glm::mat3(transformation_matrix));
@@ -35,8 +42,8 @@ namespace asr
         }
 
     private:
-        glm::vec3 _normal;
-        float _distance;
+        glm::vec3 _normal{0.0f, 1.0f, 0.0f};
+        float _distance{0.0f};
     };
 }
 
@@ -3,11 +3,13 @@
 
 #include "math/plane.h"
 #include "math/sphere.h"
+#include "math/aabb.h"
 
 #include <glm/glm.hpp>
 
 #include <utility>
 #include <cmath>
+#include <cfloat>
 
 namespace asr
 {
@@ -77,6 +79,39 @@ namespace asr
             return std::make_pair(intersects, distance);
         }
 
+        [[nodiscard]] intersection_test_result_type intersects_with_box(const AABB &box) const
+        {
+            float near_distance = 0.0f;
+            float far_distance = INFINITY;
+
+            for (int axis = 0; axis < 3; ++axis) {
+                float minimum = box.get_minimum()[axis];
+                float maximum = box.get_maximum()[axis];
+
+                if (fabsf(_direction[axis]) < FLT_EPSILON) {
+                    if (_origin[axis] < minimum || _origin[axis] > maximum) {
+                        return std::make_pair(false, 0.0f);
+                    }
+                    continue;
+                }
+
+                float inverse_direction = 1.0f / _direction[axis];
+                float entry_distance = (minimum - _origin[axis]) * inverse_direction;
+                float exit_distance = (maximum - _origin[axis]) * inverse_direction;
+                if (entry_distance > exit_distance) {
+                    std::swap(entry_distance, exit_distance);
+                }
+
+                near_distance = fmaxf(near_distance, entry_distance);
+                far_distance = fminf(far_distance, exit_distance);
+                if (near_distance > far_distance) {
+                    return std::make_pair(false, 0.0f);
+                }
+            }
+
+            return std::make_pair(true, near_distance);
+        }
+
     private:
         glm::vec3 _origin;
         glm::vec3 _direction;
@@ -4,15 +4,35 @@
 #include "objects/object.h"
 #include "geometries/geometry.h"
 #include "materials/material.h"
+#include "math/aabb.h"
+#include "math/sphere.h"
 
 #include <memory>
 #include <utility>
+#include <vector>
+#include <cstddef>
 
 namespace asr
 {
     class Mesh : public Object
     {
     public:
+        class BoundsListener
+        {
+        public:
+            virtual ~BoundsListener() = default;
+
+            virtual void on_mesh_bounds_changed(Mesh &mesh) = 0;
+        };
+
+        /* A level of detail is used while the mesh's bounding sphere covers at least screen_size of the viewport
+         * height. Levels are ordered from the finest to the coarsest; the last one is used below every threshold. */
+        struct Level
+        {
+            std::shared_ptr<Geometry> geometry;
+            float screen_size;
+        };
+
         Mesh(std::shared_ptr<Geometry> geometry, std::shared_ptr<Material> material,
              const glm::vec3 &position = glm::vec4(0.0f),
              const glm::vec3 &rotation = glm::vec4(0.0f),
@@ -28,14 +48,201 @@ namespace asr
             return _geometry;
         }
 
+        const std::vector<Level> &get_levels() const
+        {
+            return _levels;
+        }
+
+        void set_levels(std::vector<Level> levels)
+        {
+            _levels = std::move(levels);
+            _level = 0;
+            if (!_levels.empty()) {
+                _set_geometry(_levels.front().geometry);
+            }
+        }
+
+        size_t get_level() const
+        {
+            return _level;
+        }
+
+        float get_level_hysteresis() const
+        {
+            return _level_hysteresis;
+        }
+
+        void set_level_hysteresis(float level_hysteresis)
+        {
+            _level_hysteresis = level_hysteresis;
+        }
+
+        void select_level(float screen_size)
+        {
+            if (_levels.empty()) {
+                return;
+            }
+
+            // Thresholds of finer levels are raised and the current one is lowered so that a mesh hovering around a
+            // threshold does not switch back and forth every frame.
+            size_t level{_levels.size() - 1};
+            for (std::vector<Level>::size_type i = 0; i + 1 < _levels.size(); ++i) {
+                float factor{i < _level ? 1.0f + _level_hysteresis : 1.0f - _level_hysteresis};
+                if (screen_size >= _levels[i].screen_size * factor) {
+                    level = i;
+                    break;
+                }
+            }
+
+            if (level != _level) {
+                _level = level;
+                _set_geometry(_levels[level].geometry);
+            }
+        }
+
         const std::shared_ptr<Material> &get_material() const
         {
             return _material;
         }
 
+        const glm::vec4 &get_color() const
+        {
+            return _color;
+        }
+
+        void set_color(const glm::vec4 &color)
+        {
+            _color = color;
+        }
+
+        bool is_static() const
+        {
+            return _static;
+        }
+
+        void set_static(bool is_static)
+        {
+            if (_static != is_static) {
+                _static = is_static;
+                if (auto listener = get_listener()) {
+                    listener->on_object_changed(shared_from_this());
+                }
+            }
+        }
+
+        bool is_frustum_culling_enabled() const
+        {
+            return _frustum_culling_enabled;
+        }
+
+        void set_frustum_culling_enabled(bool frustum_culling_enabled)
+        {
+            if (_frustum_culling_enabled != frustum_culling_enabled) {
+                _frustum_culling_enabled = frustum_culling_enabled;
+                _notify_bounds_listener();
+            }
+        }
+
+        std::shared_ptr<BoundsListener> get_bounds_listener() const
+        {
+            return _bounds_listener.lock();
+        }
+
+        void set_bounds_listener(const std::shared_ptr<BoundsListener> &bounds_listener)
+        {
+            _bounds_listener = bounds_listener;
+        }
+
+        const AABB &get_world_bounding_box()
+        {
+            _update_world_bounds_if_necessary();
+
+            return _world_bounding_box;
+        }
+
+        const Sphere &get_world_bounding_sphere()
+        {
+            _update_world_bounds_if_necessary();
+
+            return _world_bounding_sphere;
+        }
+
+        void set_model_matrix_requires_update(bool model_matrix_requires_update) override
+        {
+            Object::set_model_matrix_requires_update(model_matrix_requires_update);
+
+            if (model_matrix_requires_update) {
+                _world_bounds_require_update = true;
+                _notify_bounds_listener();
+            }
+        }
+
+        void set_world_matrix_requires_update(bool world_matrix_requires_update) override
+        {
+            Object::set_world_matrix_requires_update(world_matrix_requires_update);
+
+            if (world_matrix_requires_update) {
+                _world_bounds_require_update = true;
+                _notify_bounds_listener();
+            }
+        }
+
     private:
         std::shared_ptr<Geometry> _geometry;
         std::shared_ptr<Material> _material;
+
+        std::vector<Level> _levels;
+        size_t _level{0};
+        float _level_hysteresis{0.0f};
+
+        glm::vec4 _color{1.0f};
+
+        bool _static{false};
+
+        bool _frustum_culling_enabled{true};
+        std::weak_ptr<BoundsListener> _bounds_listener;
+
+        bool _world_bounds_require_update{true};
+        size_t _world_bounds_geometry_version{0};
+        AABB _world_bounding_box{glm::vec3{0.0f}, glm::vec3{0.0f}};
+        Sphere _world_bounding_sphere{glm::vec3{0.0f}, 0.0f};
+
+        void _set_geometry(const std::shared_ptr<Geometry> &geometry)
+        {
+            if (_geometry != geometry) {
+                _geometry = geometry;
+                _world_bounds_require_update = true;
+                _notify_bounds_listener();
+            }
+        }
+
+        void _notify_bounds_listener()
+        {
+            if (auto bounds_listener = _bounds_listener.lock()) {
+                bounds_listener->on_mesh_bounds_changed(*this);
+            }
+        }
+
+        void _update_world_bounds_if_necessary()
+        {
+            const auto &bounding_box = _geometry->get_bounding_box();
+            const auto &bounding_sphere = _geometry->get_bounding_sphere();
+
+            if (!_world_bounds_require_update && _world_bounds_geometry_version == _geometry->get_bounds_version()) {
+                return;
+            }
+
+            const auto &world_matrix = get_world_matrix();
+
+            _world_bounding_box = bounding_box;
+            _world_bounding_box.transform(world_matrix);
+
+            _world_bounding_sphere = bounding_sphere;
+            _world_bounding_sphere.transform(world_matrix);
+
+            _world_bounds_geometry_version = _geometry->get_bounds_version();
+            _world_bounds_require_update = false;
+        }
     };
 }
 
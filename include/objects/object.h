@@ -18,6 +18,19 @@ namespace asr
     class Object : public std::enable_shared_from_this<Object>
     {
     public:
+        class Listener
+        {
+        public:
+            virtual ~Listener() = default;
+
+            virtual void on_object_added(const std::shared_ptr<Object> &object) = 0;
+
+            virtual void on_object_removed(const std::shared_ptr<Object> &object) = 0;
+
+            virtual void on_object_changed(const std::shared_ptr<Object> &object)
+            {}
+        };
+
         explicit Object(
             std::string name = "",
             const glm::vec3 &position = glm::vec3(0.0f),
@@ -61,6 +74,7 @@ namespace asr
         {
             child->set_parent(shared_from_this());
             _children.push_back(child);
+            child->set_listener(_listener.lock());
         }
 
         std::shared_ptr<Object> get_child(std::vector<std::shared_ptr<Object>>::size_type position) const
@@ -70,6 +84,7 @@ namespace asr
 
         void remove_child(std::vector<std::shared_ptr<Object>>::size_type position)
         {
+            _children[position]->set_listener(nullptr);
             _children.erase(_children.begin() + static_cast<std::vector<std::shared_ptr<Object>>::difference_type>(position));
         }
 
@@ -78,6 +93,31 @@ namespace asr
             return _children;
         }
 
+        std::shared_ptr<Listener> get_listener() const
+        {
+            return _listener.lock();
+        }
+
+        void set_listener(const std::shared_ptr<Listener> &listener)
+        {
+            auto previous_listener = _listener.lock();
+            if (previous_listener == listener) {
+                return;
+            }
+
+            if (previous_listener) {
+                previous_listener->on_object_removed(shared_from_this());
+            }
+            _listener = listener;
+            if (listener) {
+                listener->on_object_added(shared_from_this());
+            }
+
+            for (const auto &child : _children) {
+                child->set_listener(listener);
+            }
+        }
+
         glm::vec3 &get_position()
         {
             return _position;
@@ -508,6 +548,7 @@ namespace asr
 
         std::weak_ptr<Object> _parent;
         std::vector<std::shared_ptr<Object>> _children;
+        std::weak_ptr<Listener> _listener;
 
         bool _model_matrix_requires_update{true};
         glm::mat4 _model_matrix{1.0f};
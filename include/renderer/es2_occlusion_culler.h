@@ -0,0 +1,346 @@
+#ifndef ES2_OCCLUSION_CULLER_H
+#define ES2_OCCLUSION_CULLER_H
+
+#include "renderer/es2_state.h"
+#include "renderer/es2_shader.h"
+#include "renderer/es2_shader_registry.h"
+#include "utilities/utilities.h"
+#include "objects/mesh.h"
+#include "math/aabb.h"
+
+#include <GL/glew.h>
+#define SDL_MAIN_HANDLED
+#include <SDL.h>
+#include <glm/glm.hpp>
+
+#include <array>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <cstddef>
+
+namespace asr
+{
+    /* Hardware occlusion culling with temporal coherence. The meshes that were visible according to the last query
+     * result available for them are drawn first, so the CPU never waits on the GPU. Bounding boxes are then tested
+     * against that depth buffer with colour and depth writes disabled. Meshes hidden last frame get a query every
+     * frame; visible ones are re-tested every few frames with their phase staggered so that the queries spread out.
+     *
+     * Meshes hidden last frame are drawn in the same frame behind their new query with conditional rendering, so the
+     * GPU discards them only if the box is still hidden. Without conditional rendering they are skipped and appear one
+     * frame after they become visible. A mesh whose result has not arrived yet counts as visible. */
+    class ES2OcclusionCuller final
+    {
+    public:
+        ES2OcclusionCuller() = default;
+
+        ES2OcclusionCuller(const ES2OcclusionCuller &other) = delete;
+        ES2OcclusionCuller& operator=(const ES2OcclusionCuller &other) = delete;
+
+        ~ES2OcclusionCuller()
+        {
+            clear();
+
+            if (_box_vertex_array_object != 0) {
+                ES2State::get_instance().on_vertex_array_deleted(_box_vertex_array_object);
+#ifdef __APPLE__
+                glDeleteVertexArraysAPPLE(1, &_box_vertex_array_object);
+#else
+                glDeleteVertexArrays(1, &_box_vertex_array_object);
+#endif
+            }
+            if (_box_index_buffer_object != 0) {
+                glDeleteBuffers(1, &_box_index_buffer_object);
+            }
+            if (_box_vertex_buffer_object != 0) {
+                glDeleteBuffers(1, &_box_vertex_buffer_object);
+            }
+        }
+
+        [[nodiscard]] static bool is_supported()
+        {
+            return GLEW_ARB_occlusion_query || GLEW_ARB_occlusion_query2 || GLEW_EXT_occlusion_query_boolean;
+        }
+
+        [[nodiscard]] size_t get_visible_query_interval() const
+        {
+            return _visible_query_interval;
+        }
+
+        void set_visible_query_interval(size_t visible_query_interval)
+        {
+            _visible_query_interval = visible_query_interval > 0 ? visible_query_interval : 1;
+        }
+
+        [[nodiscard]] size_t get_pending_query_count() const
+        {
+            size_t pending_query_count{0};
+            for (const auto &entry : _states) {
+                if (entry.second.pending) {
+                    ++pending_query_count;
+                }
+            }
+
+            return pending_query_count;
+        }
+
+        void begin_frame()
+        {
+            ++_frame;
+            _query_meshes.clear();
+
+            for (auto entry = _states.begin(); entry != _states.end();) {
+                auto &state = entry->second;
+                if (state.pending) {
+                    GLuint available{GL_FALSE};
+                    glGetQueryObjectuiv(state.query, GL_QUERY_RESULT_AVAILABLE, &available);
+                    if (available != GL_FALSE) {
+                        GLuint samples{0};
+                        glGetQueryObjectuiv(state.query, GL_QUERY_RESULT, &samples);
+                        state.visible = samples > 0;
+                        state.pending = false;
+                    }
+                }
+
+                if (state.mesh.expired() || (!state.pending && _frame - state.frame > _StateLifetime)) {
+                    glDeleteQueries(1, &state.query);
+                    entry = _states.erase(entry);
+                } else {
+                    ++entry;
+                }
+            }
+        }
+
+        [[nodiscard]] static bool is_conditional_rendering_supported()
+        {
+            return GLEW_VERSION_3_0;
+        }
+
+        // Whether the last available result hid the mesh. Such meshes are queued for a query this frame.
+        [[nodiscard]] bool is_occluded(const std::shared_ptr<Mesh> &mesh)
+        {
+            auto entry = _states.find(mesh.get());
+            if (entry == _states.end() || entry->second.mesh.lock() != mesh) {
+                if (entry != _states.end()) {
+                    glDeleteQueries(1, &entry->second.query);
+                    _states.erase(entry);
+                }
+
+                State state;
+                state.mesh = mesh;
+                state.phase = _next_phase++;
+                glGenQueries(1, &state.query);
+                entry = _states.emplace(mesh.get(), state).first;
+            }
+
+            auto &state = entry->second;
+
+            // A mesh that was outside the frustum last frame has no recent result, so it is assumed visible. A query
+            // still in flight from before it left tested a stale box, so it is replaced rather than waited on.
+            if (state.frame + 1 != _frame) {
+                state.visible = true;
+                if (state.pending) {
+                    glDeleteQueries(1, &state.query);
+                    glGenQueries(1, &state.query);
+                    state.pending = false;
+                }
+            }
+            state.frame = _frame;
+
+            if (!state.pending && (!state.visible || (_frame + state.phase) % _visible_query_interval == 0)) {
+                _query_meshes.push_back(mesh);
+            }
+            // Drawing a mesh whose result is still in flight avoids it popping in late.
+            bool occluded{!state.visible && !state.pending};
+            if (occluded) {
+                state.occluded_frame = _frame;
+            }
+
+            return occluded;
+        }
+
+        // Whether the mesh was reported occluded this frame and can be drawn behind its new query.
+        [[nodiscard]] bool is_rendered_conditionally(const Mesh &mesh) const
+        {
+            if (!is_conditional_rendering_supported()) {
+                return false;
+            }
+
+            auto entry = _states.find(&mesh);
+
+            return entry != _states.end() && entry->second.occluded_frame == _frame && entry->second.query_frame == _frame;
+        }
+
+        /* Draws until end_conditional_render are discarded by the GPU if the mesh's query from this frame passed no
+         * samples. Returns false if the mesh has no such query, in which case it is drawn unconditionally. */
+        bool begin_conditional_render(const Mesh &mesh)
+        {
+            if (!is_rendered_conditionally(mesh)) {
+                return false;
+            }
+
+            glBeginConditionalRender(_states.find(&mesh)->second.query, GL_QUERY_WAIT);
+
+            return true;
+        }
+
+        void end_conditional_render()
+        {
+            glEndConditionalRender();
+        }
+
+        void issue_queries(const glm::mat4 &view_projection_matrix, const glm::vec3 &camera_position, float near_plane)
+        {
+            if (_query_meshes.empty() || !_prepare()) {
+                return;
+            }
+
+            auto &state = ES2State::get_instance();
+            _shader->use();
+            _shader->set_uniform(_view_projection_matrix_uniform, view_projection_matrix);
+            state.bind_vertex_array(_box_vertex_array_object);
+            state.set_blending_enabled(false);
+            state.set_face_culling_enabled(false);
+            state.set_depth_test_enabled(true);
+            state.set_depth_test_function(GL_LEQUAL);
+            state.set_depth_mask_enabled(false);
+            glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+
+            GLenum target = GLEW_ARB_occlusion_query2 || GLEW_EXT_occlusion_query_boolean ? GL_ANY_SAMPLES_PASSED : GL_SAMPLES_PASSED;
+            for (const auto &mesh : _query_meshes) {
+                auto &mesh_state = _states[mesh.get()];
+                const auto &box = mesh->get_world_bounding_box();
+
+                // The box would be clipped by the near plane when the camera is inside it.
+                if (_contains(box, camera_position, near_plane * 2.0f)) {
+                    mesh_state.visible = true;
+                    continue;
+                }
+
+                _shader->set_uniform(_box_minimum_uniform, box.get_minimum());
+                _shader->set_uniform(_box_maximum_uniform, box.get_maximum());
+
+                glBeginQuery(target, mesh_state.query);
+                glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(_box_indices.size()), GL_UNSIGNED_BYTE, nullptr);
+                glEndQuery(target);
+                mesh_state.pending = true;
+                mesh_state.query_frame = _frame;
+            }
+
+            glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+            state.set_depth_mask_enabled(true);
+            _query_meshes.clear();
+        }
+
+        void clear()
+        {
+            for (auto &entry : _states) {
+                glDeleteQueries(1, &entry.second.query);
+            }
+            _states.clear();
+            _query_meshes.clear();
+        }
+
+    private:
+        struct State
+        {
+            std::weak_ptr<Mesh> mesh;
+            GLuint query{0};
+            size_t phase{0};
+            size_t frame{0};
+            size_t occluded_frame{0};
+            size_t query_frame{0};
+            bool visible{true};
+            bool pending{false};
+        };
+
+        static constexpr size_t _StateLifetime{120};
+
+        inline static const std::array<GLfloat, 24> _box_vertices{
+            0.0f, 0.0f, 0.0f,  1.0f, 0.0f, 0.0f,  1.0f, 1.0f, 0.0f,  0.0f, 1.0f, 0.0f,
+            0.0f, 0.0f, 1.0f,  1.0f, 0.0f, 1.0f,  1.0f, 1.0f, 1.0f,  0.0f, 1.0f, 1.0f
+        };
+        inline static const std::array<GLubyte, 36> _box_indices{
+            0, 2, 1,  0, 3, 2,
+            4, 5, 6,  4, 6, 7,
+            0, 1, 5,  0, 5, 4,
+            3, 6, 2,  3, 7, 6,
+            0, 4, 7,  0, 7, 3,
+            1, 2, 6,  1, 6, 5
+        };
+
+        size_t _frame{0};
+        size_t _next_phase{0};
+        size_t _visible_query_interval{4};
+        std::unordered_map<const Mesh *, State> _states;
+        std::vector<std::shared_ptr<Mesh>> _query_meshes;
+
+        std::shared_ptr<ES2Shader> _shader;
+        Shader::Uniform _view_projection_matrix_uniform;
+        Shader::Uniform _box_minimum_uniform;
+        Shader::Uniform _box_maximum_uniform;
+        GLuint _box_vertex_array_object{0};
+        GLuint _box_vertex_buffer_object{0};
+        GLuint _box_index_buffer_object{0};
+
+        static bool _contains(const AABB &box, const glm::vec3 &point, float margin)
+        {
+            const auto &minimum = box.get_minimum();
+            const auto &maximum = box.get_maximum();
+
+            return point.x >= minimum.x - margin && point.x <= maximum.x + margin &&
+                   point.y >= minimum.y - margin && point.y <= maximum.y + margin &&
+                   point.z >= minimum.z - margin && point.z <= maximum.z + margin;
+        }
+
+        bool _prepare()
+        {
+            if (!_shader) {
+                _shader = ES2ShaderRegistry::get_instance().get_shader(
+                    file_utilities::read_text_file("data/shaders/es2_occlusion_shader.vert"),
+                    file_utilities::read_text_file("data/shaders/es2_occlusion_shader.frag"),
+                    {"position"}
+                );
+                _view_projection_matrix_uniform = _shader->add_uniform("view_projection_matrix");
+                _box_minimum_uniform = _shader->add_uniform("box_minimum");
+                _box_maximum_uniform = _shader->add_uniform("box_maximum");
+            }
+
+            if (_shader->is_dead()) {
+                return false;
+            } else if (!_shader->is_compiled()) {
+                _shader->compile();
+                if (!_shader->is_compiled()) { return false; }
+            }
+
+            if (_box_vertex_array_object == 0) {
+#ifdef __APPLE__
+                glGenVertexArraysAPPLE(1, &_box_vertex_array_object);
+#else
+                glGenVertexArrays(1, &_box_vertex_array_object);
+#endif
+                glGenBuffers(1, &_box_vertex_buffer_object);
+                glGenBuffers(1, &_box_index_buffer_object);
+
+                ES2State::get_instance().bind_vertex_array(_box_vertex_array_object);
+
+                glBindBuffer(GL_ARRAY_BUFFER, _box_vertex_buffer_object);
+                glBufferData(GL_ARRAY_BUFFER, sizeof(_box_vertices), _box_vertices.data(), GL_STATIC_DRAW);
+                int position_location{_shader->get_attribute_location(_shader->get_attribute("position"))};
+                if (position_location != -1) {
+                    glEnableVertexAttribArray(static_cast<GLuint>(position_location));
+                    glVertexAttribPointer(static_cast<GLuint>(position_location), 3, GL_FLOAT, GL_FALSE, 0, nullptr);
+                }
+                glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+                glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _box_index_buffer_object);
+                glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(_box_indices), _box_indices.data(), GL_STATIC_DRAW);
+            }
+
+            return true;
+        }
+    };
+}
+
+#endif
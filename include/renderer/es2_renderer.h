@@ -2,17 +2,41 @@
 #define ES2_RENDERER_H
 
 #include "renderer/renderer.h"
+#include "renderer/render_list.h"
+#include "renderer/frame_uniforms.h"
+#include "renderer/es2_state.h"
+#include "renderer/es2_shader.h"
+#include "renderer/es2_static_batch.h"
+#include "renderer/es2_occlusion_culler.h"
+#include "utilities/utilities.h"
+#include "utilities/worker_pool.h"
 #include "objects/object.h"
 #include "objects/mesh.h"
+#include "geometries/es2_geometry.h"
+#include "geometries/vertex.h"
+#include "math/frustum.h"
 
 #include <GL/glew.h>
 #define SDL_MAIN_HANDLED
 #include <SDL.h>
 #include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <glm/gtc/matrix_inverse.hpp>
 
 #include <algorithm>
-#include <queue>
+#include <array>
+#include <iterator>
+#include <limits>
+#include <map>
 #include <memory>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
 
 namespace asr
 {
@@ -22,26 +46,158 @@ namespace asr
         ES2Renderer(const std::shared_ptr<Scene> &scene, const std::shared_ptr<Window> &window)
             : Renderer(scene, window)
         {
+            ES2State::get_instance().invalidate();
+
             glm::vec4 clear_color = scene->get_clear_color();
             glClearColor(clear_color.r, clear_color.g, clear_color.b, clear_color.a);
 
             glEnable(GL_PROGRAM_POINT_SIZE);
 
-            std::queue<std::shared_ptr<Object>> queue;
-            queue.push(scene->get_root());
-            while (!queue.empty()) {
-                const auto object = queue.front(); queue.pop();
-                if (auto mesh = std::dynamic_pointer_cast<Mesh>(object)) {
-                    const auto &geometry = mesh->get_geometry();
-                    const auto &material = mesh->get_material();
+            _attach_render_list();
+            _frame_uniforms.update(*scene);
+            for (const auto &mesh : _render_list->get_meshes()) {
+                const auto &geometry = mesh->get_geometry();
+                const auto &material = mesh->get_material();
 
-                    material->use();
-                    material->update(scene, mesh);
+                material->use();
+                material->update(_frame_uniforms, mesh);
+                if (material->is_ready()) {
                     geometry->update(*mesh->get_material());
                 }
+            }
+        }
+
+        ~ES2Renderer() override
+        {
+            if (_instance_buffer_object != 0) {
+                glDeleteBuffers(1, &_instance_buffer_object);
+            }
+            for (auto &entry : _instance_copies) {
+                _delete_instance_copies(entry.second);
+            }
 
-                for (const auto &child: object->get_children()) { queue.push(child); }
+            if (_sprite_vertex_array_object != 0) {
+                ES2State::get_instance().on_vertex_array_deleted(_sprite_vertex_array_object);
+#ifdef __APPLE__
+                glDeleteVertexArraysAPPLE(1, &_sprite_vertex_array_object);
+#else
+                glDeleteVertexArrays(1, &_sprite_vertex_array_object);
+#endif
             }
+            if (_sprite_index_buffer_object != 0) {
+                glDeleteBuffers(1, &_sprite_index_buffer_object);
+            }
+            if (_sprite_vertex_buffer_object != 0) {
+                glDeleteBuffers(1, &_sprite_vertex_buffer_object);
+            }
+        }
+
+        [[nodiscard]] bool is_frustum_culling_enabled() const
+        {
+            return _frustum_culling_enabled;
+        }
+
+        void set_frustum_culling_enabled(bool frustum_culling_enabled)
+        {
+            _frustum_culling_enabled = frustum_culling_enabled;
+        }
+
+        [[nodiscard]] bool is_occlusion_culling_enabled() const
+        {
+            return _occlusion_culling_enabled;
+        }
+
+        void set_occlusion_culling_enabled(bool occlusion_culling_enabled)
+        {
+            _occlusion_culling_enabled = occlusion_culling_enabled;
+            if (!_occlusion_culling_enabled) {
+                _occlusion_culler.clear();
+            }
+        }
+
+        [[nodiscard]] ES2OcclusionCuller &get_occlusion_culler()
+        {
+            return _occlusion_culler;
+        }
+
+        [[nodiscard]] size_t get_worker_count() const
+        {
+            return _worker_pool->get_worker_count();
+        }
+
+        void set_worker_count(size_t worker_count)
+        {
+            if (worker_count != _worker_pool->get_worker_count()) {
+                _worker_pool = std::make_unique<WorkerPool>(worker_count);
+            }
+        }
+
+        [[nodiscard]] const std::shared_ptr<BVH> &get_bvh() const
+        {
+            return _render_list->get_bvh();
+        }
+
+        [[nodiscard]] bool is_instancing_enabled() const
+        {
+            return _instancing_enabled;
+        }
+
+        void set_instancing_enabled(bool instancing_enabled)
+        {
+            _instancing_enabled = instancing_enabled;
+        }
+
+        [[nodiscard]] bool is_static_batching_enabled() const
+        {
+            return _static_batching_enabled;
+        }
+
+        void set_static_batching_enabled(bool static_batching_enabled)
+        {
+            _static_batching_enabled = static_batching_enabled;
+        }
+
+        [[nodiscard]] size_t get_static_batch_count() const
+        {
+            return _static_batches.size();
+        }
+
+        [[nodiscard]] bool is_sprite_batching_enabled() const
+        {
+            return _sprite_batching_enabled;
+        }
+
+        void set_sprite_batching_enabled(bool sprite_batching_enabled)
+        {
+            _sprite_batching_enabled = sprite_batching_enabled;
+        }
+
+        [[nodiscard]] size_t get_drawn_mesh_count() const
+        {
+            return _drawn_mesh_count;
+        }
+
+        [[nodiscard]] size_t get_culled_mesh_count() const
+        {
+            return _culled_mesh_count;
+        }
+
+        /* Meshes hidden by their last occlusion query and skipped for the frame. Without conditional rendering that is
+         * every hidden mesh; with it, hidden meshes are still submitted and counted as drawn and conditionally drawn. */
+        [[nodiscard]] size_t get_occluded_mesh_count() const
+        {
+            return _occluded_mesh_count;
+        }
+
+        // Hidden meshes submitted behind conditional rendering, which the GPU discards if their new query fails.
+        [[nodiscard]] size_t get_conditionally_drawn_mesh_count() const
+        {
+            return _conditionally_drawn_mesh_count;
+        }
+
+        [[nodiscard]] size_t get_draw_call_count() const
+        {
+            return _draw_call_count;
         }
 
         void render() final
@@ -58,38 +214,76 @@ namespace asr
                 camera->set_viewport(glm::vec4(0, 0, window->get_width(), window->get_height()));
             }
 
-            std::vector<std::shared_ptr<Mesh>> opaque, transparent, overlays;
-            std::queue<std::shared_ptr<Object>> queue;
-            queue.push(scene->get_root());
-            while (!queue.empty()) {
-                const auto object = queue.front(); queue.pop();
-                if (auto mesh = std::dynamic_pointer_cast<Mesh>(object)) {
-                    auto material = mesh->get_material();
-                    if (material->is_overlay()) {
-                        overlays.push_back(mesh);
-                    } else if (material->is_transparent()) {
-                        transparent.push_back(mesh);
-                    } else {
-                        opaque.push_back(mesh);
-                    }
-                }
+            _frame_uniforms.update(*scene);
+            ES2Shader::begin_frame();
 
-                for (const auto &child: object->get_children()) { queue.push(child); }
+            if (scene->get_root() != _render_list_root) {
+                _attach_render_list();
             }
 
-            std::sort(std::begin(transparent), std::end(transparent), [&](const auto &a, const auto &b) {
-                return glm::length(camera->get_world_position() - a->get_world_position()) >
-                           glm::length(camera->get_world_position() - b->get_world_position());
-            });
-            std::sort(std::begin(overlays), std::end(overlays), [](const auto &a, const auto &b) {
-                return a->get_material()->get_overlay_priority() > b->get_material()->get_overlay_priority();
+            _drawn_mesh_count = 0;
+            _culled_mesh_count = 0;
+            _occluded_mesh_count = 0;
+            _conditionally_drawn_mesh_count = 0;
+            _draw_call_count = 0;
+            _frustum.set_from_matrix(camera->get_view_projection_matrix());
+
+            _update_static_batches();
+            _update_transforms();
+            _cull_meshes();
+            _cull_occluded_meshes();
+            _select_mesh_levels(camera->get_world_position(), camera->get_projection_matrix());
+            auto &overlays = _render_list->get_overlay_meshes();
+
+            const auto &view_matrix = _frame_uniforms.get_view_matrix();
+            _sort_opaque_meshes(view_matrix);
+            _sort_transparent_meshes(view_matrix);
+            _sort_meshes(overlays, [](Mesh &mesh, size_t) {
+                return _make_overlay_sort_key(mesh);
             });
 
-            for (auto &mesh : opaque) {
-                _render_mesh(mesh);
+            _pack_draw_data(_visible_opaque_meshes, _opaque_draw_data);
+            _pack_draw_data(_visible_transparent_meshes, _transparent_draw_data);
+
+            _release_expired_instance_copies();
+            _group_opaque_meshes();
+            // Static batches go after the order-dependent meshes submitted before every other opaque mesh, such as
+            // backgrounds drawn without depth testing.
+            bool static_batches_rendered{false};
+            for (size_t i = 0; i < _instance_group_count; ++i) {
+                const auto &group = _instance_groups[i];
+                if (!static_batches_rendered && _is_order_independent(*group.front()->get_material())) {
+                    _render_static_batches();
+                    static_batches_rendered = true;
+                }
+                if (group.size() > 1) {
+                    _render_instances(group);
+                } else {
+                    _render_mesh(group.front(), 1, &_opaque_draw_data[_instance_group_first_meshes[i]]);
+                }
             }
-            for (auto &mesh : transparent) {
-                _render_mesh(mesh);
+            if (!static_batches_rendered) {
+                _render_static_batches();
+            }
+            if (_is_occlusion_culling_active()) {
+                _occlusion_culler.issue_queries(
+                    camera->get_view_projection_matrix(), camera->get_world_position(), camera->get_near_plane()
+                );
+                for (const auto &mesh : _occluded_opaque_meshes) {
+                    _render_mesh_conditionally(mesh);
+                }
+            }
+            _batch_sprites();
+            std::vector<SpriteBatch>::size_type sprite_batch_index{0};
+            for (size_t i = 0; i < _visible_transparent_meshes.size();) {
+                if (sprite_batch_index < _sprite_batches.size() && _sprite_batches[sprite_batch_index].first_mesh == i) {
+                    const auto &sprite_batch = _sprite_batches[sprite_batch_index++];
+                    _render_sprite_batch(sprite_batch);
+                    i += sprite_batch.mesh_count;
+                } else {
+                    _render_mesh_conditionally(_visible_transparent_meshes[i], &_transparent_draw_data[i]);
+                    ++i;
+                }
             }
             for (auto &mesh : overlays) {
                 _render_mesh(mesh);
@@ -99,24 +293,1087 @@ namespace asr
         }
 
     private:
-        void _render_mesh(const std::shared_ptr<Mesh> &mesh) const
+        std::shared_ptr<RenderList> _render_list{std::make_shared<RenderList>()};
+        std::shared_ptr<Object> _render_list_root;
+
+        FrameUniforms _frame_uniforms;
+
+        static constexpr size_t _MinimumBatchSize{64};
+
+        std::unique_ptr<WorkerPool> _worker_pool{std::make_unique<WorkerPool>()};
+        std::vector<FrameUniforms::DrawData> _opaque_draw_data;
+        std::vector<FrameUniforms::DrawData> _transparent_draw_data;
+
+        bool _frustum_culling_enabled{true};
+        Frustum _frustum;
+        std::vector<std::shared_ptr<Mesh>> _visible_meshes;
+        std::vector<std::shared_ptr<Mesh>> _visible_opaque_meshes;
+        std::vector<std::shared_ptr<Mesh>> _visible_transparent_meshes;
+        size_t _drawn_mesh_count{0};
+        size_t _culled_mesh_count{0};
+        size_t _occluded_mesh_count{0};
+        size_t _conditionally_drawn_mesh_count{0};
+        size_t _draw_call_count{0};
+
+        bool _occlusion_culling_enabled{false};
+        ES2OcclusionCuller _occlusion_culler;
+        std::vector<std::shared_ptr<Mesh>> _occluded_opaque_meshes;
+
+        static constexpr size_t _InstanceFloatCount{20};
+
+        bool _static_batching_enabled{false};
+        size_t _static_batches_version{0};
+        std::vector<std::unique_ptr<ES2StaticBatch>> _static_batches;
+        std::unordered_set<const Mesh *> _batched_meshes;
+
+        struct SpriteBatch
+        {
+            size_t first_mesh;
+            size_t mesh_count;
+            size_t first_index;
+            size_t index_count;
+        };
+
+        bool _sprite_batching_enabled{true};
+        std::vector<SpriteBatch> _sprite_batches;
+        std::vector<Vertex> _sprite_vertices;
+        std::vector<Vertex> _sprite_mesh_vertices;
+        std::vector<unsigned int> _sprite_indices;
+        std::vector<uint16_t> _sprite_short_indices;
+        Geometry::IndexType _sprite_index_type{Geometry::IndexType::UnsignedIntIndices};
+        std::shared_ptr<Mesh> _sprite_mesh{std::make_shared<Mesh>(nullptr, nullptr)};
+        GLuint _sprite_vertex_array_object{0};
+        GLuint _sprite_vertex_buffer_object{0};
+        GLuint _sprite_index_buffer_object{0};
+
+        /* 64-bit draw sort keys, most significant bits first:
+         *   opaque:      pass (2) | sequential (1) | program (13) | texture (12) | geometry (12) | depth (24)
+         *   sequential:  pass (2) | 1 (1) | render order (61), for materials whose result depends on draw order
+         * Sequential meshes are barriers: they keep their place in submission order and only the runs of opaque
+         * meshes between them are sorted.
+         *   transparent: pass (2) | inverted depth (32)
+         *   overlay:     pass (2) | inverted priority (32)
+         * Depth is the view-space depth, encoded with sort_utilities::get_ordered_float_bits. */
+        static constexpr unsigned int _PassShift{62};
+        static constexpr uint64_t _OpaquePass{0}, _TransparentPass{1}, _OverlayPass{2};
+        static constexpr uint64_t _SequentialBit{1ull << 61u};
+        static constexpr unsigned int _ProgramBits{13}, _ProgramShift{48};
+        static constexpr unsigned int _TextureBits{12}, _TextureShift{36};
+        static constexpr unsigned int _GeometryBits{12}, _GeometryShift{24};
+
+        std::vector<std::pair<uint64_t, std::shared_ptr<Mesh>>> _sort_items;
+        std::vector<std::pair<uint64_t, std::shared_ptr<Mesh>>> _sort_buffer;
+        std::vector<std::pair<uint64_t, std::shared_ptr<Mesh>>> _sort_run_items;
+        std::vector<size_t> _sort_slots;
+        std::unordered_map<const Mesh *, size_t> _transparent_mesh_ranks;
+        std::unordered_map<const void *, uint64_t> _program_sort_ids;
+        std::unordered_map<const void *, uint64_t> _texture_sort_ids;
+        std::unordered_map<const void *, uint64_t> _geometry_sort_ids;
+
+        bool _instancing_enabled{true};
+        std::map<std::pair<const Geometry *, const Material *>, size_t> _instance_group_indices;
+        std::vector<std::vector<std::shared_ptr<Mesh>>> _instance_groups;
+        std::vector<size_t> _instance_group_first_meshes;
+        size_t _instance_group_count{0};
+        std::vector<GLfloat> _instance_data;
+        GLuint _instance_buffer_object{0};
+
+        /* Without per-instance attributes, instances are drawn from copies of their geometry packed into one buffer.
+         * Every vertex carries the index of its copy, which selects the instance's matrix and colour from uniform
+         * arrays, so one draw call covers up to Material::InstanceUniformArraySize instances. Geometries with many
+         * vertices get fewer copies to keep the memory bounded and the indices within 16 bits. */
+        struct InstanceCopies
+        {
+            size_t geometry_version{std::numeric_limits<size_t>::max()};
+            size_t copy_count{0};
+            size_t copy_index_count{0};
+            Geometry::Type type{Geometry::Type::Triangles};
+            Geometry::IndexType index_type{Geometry::IndexType::UnsignedIntIndices};
+            int generic_color_location{-1};
+            GLuint vertex_array_object{0};
+            GLuint vertex_buffer_object{0};
+            GLuint instance_index_buffer_object{0};
+            GLuint index_buffer_object{0};
+        };
+
+        /* The copies' vertex array object enables the attributes of the shader that built it, so materials and
+         * shader variants drawing the same geometry each get their own copies. */
+        using InstanceCopiesKey = std::pair<std::weak_ptr<Geometry>, std::weak_ptr<Shader>>;
+
+        struct InstanceCopiesKeyLess
+        {
+            bool operator()(const InstanceCopiesKey &a, const InstanceCopiesKey &b) const
+            {
+                std::owner_less<> less;
+                if (less(a.first, b.first)) {
+                    return true;
+                }
+                if (less(b.first, a.first)) {
+                    return false;
+                }
+
+                return less(a.second, b.second);
+            }
+        };
+
+        static constexpr size_t _InstanceCopiesMaxVertexCount{65536};
+
+        std::map<InstanceCopiesKey, InstanceCopies, InstanceCopiesKeyLess> _instance_copies;
+        std::vector<uint8_t> _instance_copy_vertex_data;
+        std::vector<GLfloat> _instance_copy_slots;
+        std::vector<unsigned int> _instance_copy_indices;
+        std::vector<uint16_t> _instance_copy_short_indices;
+        std::vector<glm::mat4> _instance_matrices;
+        std::vector<glm::vec4> _instance_colors;
+
+        void _attach_render_list()
+        {
+            if (_render_list_root) {
+                _render_list_root->set_listener(nullptr);
+            }
+            _render_list_root = scene->get_root();
+            _render_list_root->set_listener(_render_list);
+        }
+
+        /* Brings world matrices and bounds up to date on the worker pool. Parents and shared geometries are updated
+         * here first so that the workers only ever write to the mesh they were given. */
+        void _update_transforms()
+        {
+            auto &opaque = _render_list->get_opaque_meshes();
+            auto &transparent = _render_list->get_transparent_meshes();
+            auto &overlays = _render_list->get_overlay_meshes();
+
+            for (const auto *meshes : {&opaque, &transparent, &overlays}) {
+                for (const auto &mesh : *meshes) {
+                    if (auto parent = mesh->get_parent().lock()) {
+                        parent->get_world_matrix();
+                    }
+                    mesh->get_geometry()->get_bounding_box();
+                }
+            }
+
+            for (auto *meshes : {&opaque, &transparent, &overlays}) {
+                _worker_pool->parallel_for(meshes->size(), _MinimumBatchSize, [&](size_t begin, size_t end) {
+                    for (size_t i = begin; i < end; ++i) {
+                        (*meshes)[i]->get_world_bounding_box();
+                    }
+                });
+            }
+        }
+
+        void _cull_meshes()
+        {
+            const auto &opaque = _render_list->get_opaque_meshes();
+            const auto &transparent = _render_list->get_transparent_meshes();
+
+            if (!_frustum_culling_enabled) {
+                _visible_opaque_meshes.clear();
+                for (const auto &mesh : opaque) {
+                    if (_batched_meshes.count(mesh.get()) == 0) {
+                        _visible_opaque_meshes.push_back(mesh);
+                    }
+                }
+                _visible_transparent_meshes.assign(std::begin(transparent), std::end(transparent));
+                return;
+            }
+
+            const auto &bvh = _render_list->get_bvh();
+            bvh->update();
+
+            _visible_meshes.clear();
+            bvh->query_frustum(_frustum, _visible_meshes);
+            std::sort(std::begin(_visible_meshes), std::end(_visible_meshes), [&](const auto &a, const auto &b) {
+                return _render_list->get_mesh_index(*a) < _render_list->get_mesh_index(*b);
+            });
+
+            _visible_opaque_meshes.clear();
+            _visible_transparent_meshes.clear();
+            for (const auto &mesh : _visible_meshes) {
+                const auto &material = mesh->get_material();
+                if (material->is_overlay() || _batched_meshes.count(mesh.get()) > 0) {
+                    continue;
+                } else if (material->is_transparent()) {
+                    _visible_transparent_meshes.push_back(mesh);
+                } else {
+                    _visible_opaque_meshes.push_back(mesh);
+                }
+            }
+
+            _culled_mesh_count = opaque.size() + transparent.size() - _batched_meshes.size() -
+                                 _visible_opaque_meshes.size() - _visible_transparent_meshes.size();
+        }
+
+        [[nodiscard]] bool _is_occlusion_culling_active() const
+        {
+            return _occlusion_culling_enabled && ES2OcclusionCuller::is_supported();
+        }
+
+        /* Meshes hidden by their last query result are taken out of the opaque pass. With conditional rendering they
+         * are drawn after their new queries have been issued, and transparent ones keep their place in the sorted
+         * order; without it they are skipped for this frame. */
+        void _cull_occluded_meshes()
+        {
+            _occluded_opaque_meshes.clear();
+            if (!_is_occlusion_culling_active()) {
+                return;
+            }
+
+            _occlusion_culler.begin_frame();
+            bool conditional{ES2OcclusionCuller::is_conditional_rendering_supported()};
+            for (auto *meshes : {&_visible_opaque_meshes, &_visible_transparent_meshes}) {
+                bool opaque{meshes == &_visible_opaque_meshes};
+                meshes->erase(std::remove_if(std::begin(*meshes), std::end(*meshes), [&](const auto &mesh) {
+                    if (!_occlusion_culler.is_occluded(mesh)) {
+                        return false;
+                    }
+
+                    if (!conditional) {
+                        ++_occluded_mesh_count;
+                        return true;
+                    }
+
+                    ++_conditionally_drawn_mesh_count;
+                    if (opaque) {
+                        _occluded_opaque_meshes.push_back(mesh);
+                    }
+
+                    return opaque;
+                }), std::end(*meshes));
+            }
+        }
+
+        void _render_mesh_conditionally(
+            const std::shared_ptr<Mesh> &mesh, const FrameUniforms::DrawData *draw_data = nullptr
+        )
+        {
+            bool conditional{_is_occlusion_culling_active() && _occlusion_culler.begin_conditional_render(*mesh)};
+            _render_mesh(mesh, 1, draw_data);
+            if (conditional) {
+                _occlusion_culler.end_conditional_render();
+            }
+        }
+
+        void _select_mesh_levels(const glm::vec3 &camera_position, const glm::mat4 &projection_matrix)
+        {
+            for (auto *meshes : {&_visible_opaque_meshes, &_occluded_opaque_meshes, &_visible_transparent_meshes}) {
+                for (const auto &mesh : *meshes) {
+                    if (!mesh->get_levels().empty()) {
+                        mesh->select_level(_get_screen_size(*mesh, camera_position, projection_matrix));
+                    }
+                }
+            }
+        }
+
+        /* The bounding sphere's projected diameter as a fraction of the viewport height. */
+        static float _get_screen_size(Mesh &mesh, const glm::vec3 &camera_position, const glm::mat4 &projection_matrix)
+        {
+            const auto &sphere = mesh.get_world_bounding_sphere();
+            float radius{sphere.get_radius()};
+
+            if (projection_matrix[2][3] == 0.0f) {
+                return radius * projection_matrix[1][1];
+            }
+
+            float distance{glm::length(sphere.get_center() - camera_position)};
+            if (distance <= radius) {
+                return std::numeric_limits<float>::max();
+            }
+
+            return radius * projection_matrix[1][1] / distance;
+        }
+
+        void _update_static_batches()
+        {
+            if (!_static_batching_enabled) {
+                _static_batches.clear();
+                _static_batches_version = 0;
+                _batched_meshes.clear();
+                return;
+            }
+
+            bool requires_regrouping{_static_batches_version != _render_list->get_version()};
+            for (const auto &static_batch : _static_batches) {
+                requires_regrouping = requires_regrouping || !static_batch->is_valid();
+            }
+            if (requires_regrouping) {
+                _group_static_meshes();
+            }
+
+            for (const auto &static_batch : _static_batches) {
+                if (static_batch->requires_rebuild()) {
+                    static_batch->rebuild();
+                }
+                static_batch->update_world_matrix();
+            }
+        }
+
+        void _group_static_meshes()
+        {
+            std::map<std::tuple<const Object *, const Material *, Geometry::Type, float>, std::vector<std::shared_ptr<Mesh>>> groups;
+            for (const auto &mesh : _render_list->get_opaque_meshes()) {
+                const auto &material = mesh->get_material();
+                if (!mesh->is_static() || !_is_order_independent(*material)) {
+                    continue;
+                }
+
+                const auto &geometry = mesh->get_geometry();
+                auto type = ES2StaticBatch::get_batch_type(geometry->get_type());
+                float line_width{type == Geometry::Type::Lines ? geometry->get_line_width() : 0.0f};
+                groups[std::make_tuple(mesh->get_parent().lock().get(), material.get(), type, line_width)].push_back(mesh);
+            }
+
+            std::vector<std::unique_ptr<ES2StaticBatch>> static_batches;
+            _batched_meshes.clear();
+            for (auto &group : groups) {
+                auto &meshes = group.second;
+                if (meshes.size() < 2) {
+                    continue;
+                }
+
+                auto existing_batch = std::find_if(std::begin(_static_batches), std::end(_static_batches), [&](const auto &static_batch) {
+                    return static_batch && static_batch->get_meshes() == meshes;
+                });
+                if (existing_batch != std::end(_static_batches)) {
+                    static_batches.push_back(std::move(*existing_batch));
+                } else {
+                    static_batches.push_back(std::make_unique<ES2StaticBatch>(std::move(meshes)));
+                }
+
+                for (const auto &mesh : static_batches.back()->get_meshes()) {
+                    _batched_meshes.insert(mesh.get());
+                }
+            }
+
+            _static_batches = std::move(static_batches);
+            _static_batches_version = _render_list->get_version();
+        }
+
+        void _render_static_batches()
+        {
+            for (const auto &static_batch : _static_batches) {
+                const auto &mesh = static_batch->get_mesh();
+                auto mesh_count = static_batch->get_meshes().size();
+
+                if (_frustum_culling_enabled && mesh->is_frustum_culling_enabled() &&
+                    !_frustum.intersects_box(mesh->get_world_bounding_box())) {
+                    _culled_mesh_count += mesh_count;
+                    continue;
+                }
+
+                _render_mesh(mesh, mesh_count);
+            }
+        }
+        template<typename SortKeyFunction>
+        void _sort_meshes(std::vector<std::shared_ptr<Mesh>> &meshes, SortKeyFunction make_sort_key)
+        {
+            _sort_items.clear();
+            for (size_t i = 0; i < meshes.size(); ++i) {
+                _sort_items.emplace_back(make_sort_key(*meshes[i], i), std::move(meshes[i]));
+            }
+
+            sort_utilities::radix_sort(_sort_items, _sort_buffer);
+
+            for (size_t i = 0; i < meshes.size(); ++i) {
+                meshes[i] = std::move(_sort_items[i].second);
+            }
+        }
+
+        void _sort_opaque_meshes(const glm::mat4 &view_matrix)
+        {
+            auto &meshes = _visible_opaque_meshes;
+
+            _sort_items.resize(meshes.size());
+            _worker_pool->parallel_for(meshes.size(), _MinimumBatchSize, [&](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; ++i) {
+                    _sort_items[i] = std::make_pair(_make_opaque_sort_key(*meshes[i], i, view_matrix), std::move(meshes[i]));
+                }
+            });
+
+            /* Dense ids are handed out on this thread to the states of this frame's meshes and forgotten afterwards,
+             * so they never change while the keys are built and the maps keep no pointers to freed objects. */
+            for (auto &item : _sort_items) {
+                if ((item.first & _SequentialBit) == 0) {
+                    item.first |= _make_opaque_state_sort_key(*item.second);
+                }
+            }
+            _program_sort_ids.clear();
+            _texture_sort_ids.clear();
+            _geometry_sort_ids.clear();
+
+            size_t run_begin{0};
+            for (size_t i = 0; i <= _sort_items.size(); ++i) {
+                if (i < _sort_items.size() && (_sort_items[i].first & _SequentialBit) == 0) {
+                    continue;
+                }
+
+                if (run_begin == 0 && i == _sort_items.size()) {
+                    sort_utilities::radix_sort(_sort_items, _sort_buffer);
+                } else if (i - run_begin > 1) {
+                    auto begin = std::begin(_sort_items) + static_cast<std::ptrdiff_t>(run_begin);
+                    auto end = std::begin(_sort_items) + static_cast<std::ptrdiff_t>(i);
+                    _sort_run_items.assign(std::make_move_iterator(begin), std::make_move_iterator(end));
+                    sort_utilities::radix_sort(_sort_run_items, _sort_buffer);
+                    std::move(std::begin(_sort_run_items), std::end(_sort_run_items), begin);
+                }
+                run_begin = i + 1;
+            }
+
+            for (size_t i = 0; i < meshes.size(); ++i) {
+                meshes[i] = std::move(_sort_items[i].second);
+            }
+        }
+
+        void _sort_transparent_meshes(const glm::mat4 &view_matrix)
+        {
+            auto &meshes = _visible_transparent_meshes;
+
+            _sort_slots.resize(meshes.size());
+            bool previous_order_available{meshes.size() == _transparent_mesh_ranks.size()};
+            for (size_t i = 0; previous_order_available && i < meshes.size(); ++i) {
+                auto rank = _transparent_mesh_ranks.find(meshes[i].get());
+                previous_order_available = rank != _transparent_mesh_ranks.end();
+                if (previous_order_available) {
+                    _sort_slots[i] = rank->second;
+                }
+            }
+
+            _sort_items.resize(meshes.size());
+            _worker_pool->parallel_for(meshes.size(), _MinimumBatchSize, [&](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; ++i) {
+                    auto slot = previous_order_available ? _sort_slots[i] : i;
+                    _sort_items[slot] = std::make_pair(_make_transparent_sort_key(*meshes[i], view_matrix), std::move(meshes[i]));
+                }
+            });
+
+            bool sorted = std::is_sorted(std::begin(_sort_items), std::end(_sort_items), [](const auto &a, const auto &b) {
+                return a.first < b.first;
+            });
+            if (!sorted) {
+                sort_utilities::radix_sort(_sort_items, _sort_buffer);
+            }
+
+            for (size_t i = 0; i < meshes.size(); ++i) {
+                meshes[i] = std::move(_sort_items[i].second);
+            }
+
+            if (!previous_order_available || !sorted) {
+                _transparent_mesh_ranks.clear();
+                for (size_t i = 0; i < meshes.size(); ++i) {
+                    _transparent_mesh_ranks[meshes[i].get()] = i;
+                }
+            }
+        }
+
+        static uint64_t _make_opaque_sort_key(Mesh &mesh, size_t index, const glm::mat4 &view_matrix)
+        {
+            if (!_is_order_independent(*mesh.get_material())) {
+                return (_OpaquePass << _PassShift) | _SequentialBit | static_cast<uint64_t>(index);
+            }
+
+            uint64_t depth = sort_utilities::get_ordered_float_bits(_get_view_depth(mesh, view_matrix)) >> 8u;
+
+            return (_OpaquePass << _PassShift) | depth;
+        }
+
+        uint64_t _make_opaque_state_sort_key(const Mesh &mesh)
+        {
+            const auto &material = mesh.get_material();
+
+            uint64_t program = _get_sort_id(_program_sort_ids, material->get_shader().get(), _ProgramBits);
+            const auto *primary_texture = material->get_primary_texture();
+            uint64_t texture = _get_sort_id(
+                _texture_sort_ids, primary_texture ? primary_texture->get_image_texture() : nullptr, _TextureBits
+            );
+            uint64_t geometry = _get_sort_id(_geometry_sort_ids, mesh.get_geometry().get(), _GeometryBits);
+
+            return (program << _ProgramShift) | (texture << _TextureShift) | (geometry << _GeometryShift);
+        }
+
+        static uint64_t _make_transparent_sort_key(Mesh &mesh, const glm::mat4 &view_matrix)
+        {
+            uint64_t depth = sort_utilities::get_ordered_float_bits(_get_view_depth(mesh, view_matrix));
+
+            return (_TransparentPass << _PassShift) | (~depth & 0xffffffffull);
+        }
+
+        static uint64_t _make_overlay_sort_key(const Mesh &mesh)
+        {
+            auto priority = static_cast<uint32_t>(mesh.get_material()->get_overlay_priority()) ^ 0x80000000u;
+
+            return (_OverlayPass << _PassShift) | static_cast<uint64_t>(~priority);
+        }
+
+        static uint64_t _get_sort_id(std::unordered_map<const void *, uint64_t> &sort_ids, const void *object, unsigned int bits)
+        {
+            auto entry = sort_ids.find(object);
+            if (entry != sort_ids.end()) {
+                return entry->second;
+            }
+
+            // States beyond the field's range share its last id, which only loosens their grouping.
+            auto sort_id = std::min<uint64_t>(sort_ids.size(), (uint64_t{1} << bits) - 1);
+            sort_ids.emplace(object, sort_id);
+
+            return sort_id;
+        }
+
+        static float _get_view_depth(Mesh &mesh, const glm::mat4 &view_matrix)
+        {
+            const auto &position = mesh.get_world_position();
+
+            return -(view_matrix[0][2] * position.x + view_matrix[1][2] * position.y + view_matrix[2][2] * position.z + view_matrix[3][2]);
+        }
+
+        void _pack_draw_data(const std::vector<std::shared_ptr<Mesh>> &meshes, std::vector<FrameUniforms::DrawData> &draw_data)
+        {
+            const auto &view_matrix = _frame_uniforms.get_view_matrix();
+
+            draw_data.resize(meshes.size());
+            _worker_pool->parallel_for(meshes.size(), _MinimumBatchSize, [&](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; ++i) {
+                    auto &data = draw_data[i];
+                    data.model_view_matrix = view_matrix * meshes[i]->get_world_matrix();
+                    data.normal_matrix = glm::inverseTranspose(glm::mat3(data.model_view_matrix));
+                }
+            });
+        }
+
+        // Sprites and billboards are single quads, either as a pair of triangles or as a four-vertex strip or fan.
+        [[nodiscard]] static bool _is_sprite(const Mesh &mesh)
+        {
+            const auto &geometry = mesh.get_geometry();
+            if (geometry->get_vertices().size() != 4) {
+                return false;
+            }
+
+            auto index_count = geometry->get_indices().size();
+            switch (geometry->get_type()) {
+                case Geometry::Type::Triangles:
+                    return index_count == 6;
+                case Geometry::Type::TriangleStrip:
+                case Geometry::Type::TriangleFan:
+                    return index_count == 4;
+                case Geometry::Type::Points:
+                case Geometry::Type::Lines:
+                case Geometry::Type::LineLoop:
+                case Geometry::Type::LineStrip:
+                    return false;
+            }
+
+            return false;
+        }
+
+        /* Only the transformed s and t of (s, t, 0, 1) are read by the shaders, so a texture transformation acts on
+         * sprites as a 2D affine map. */
+        [[nodiscard]] static glm::mat3 _get_texture_transformation(const Texture *texture)
+        {
+            if (texture == nullptr || !texture->is_transformation_enabled()) {
+                return glm::mat3{1.0f};
+            }
+
+            const auto &matrix = texture->get_transformation_matrix();
+
+            return glm::mat3{
+                glm::vec3{matrix[0][0], matrix[0][1], 0.0f},
+                glm::vec3{matrix[1][0], matrix[1][1], 0.0f},
+                glm::vec3{matrix[3][0], matrix[3][1], 1.0f}
+            };
+        }
+
+        // A batch is drawn with its first sprite's texture transformations, which are undone for the other sprites.
+        [[nodiscard]] static bool _has_invertible_texture_transformations(const Material &material)
+        {
+            return glm::determinant(_get_texture_transformation(material.get_primary_texture())) != 0.0f &&
+                   glm::determinant(_get_texture_transformation(material.get_secondary_texture())) != 0.0f;
+        }
+
+        [[nodiscard]] bool _is_batchable_sprite(const Mesh &mesh) const
+        {
+            return _is_sprite(mesh) &&
+                   !(_is_occlusion_culling_active() && _occlusion_culler.is_rendered_conditionally(mesh));
+        }
+
+        void _batch_sprites()
+        {
+            _sprite_batches.clear();
+            _sprite_vertices.clear();
+            _sprite_indices.clear();
+
+            if (!_sprite_batching_enabled) {
+                return;
+            }
+
+            const auto &meshes = _visible_transparent_meshes;
+            for (size_t first = 0; first < meshes.size();) {
+                size_t last{first + 1};
+                const auto &material = meshes[first]->get_material();
+                if (_is_batchable_sprite(*meshes[first]) && _has_invertible_texture_transformations(*material)) {
+                    while (last < meshes.size() && _is_batchable_sprite(*meshes[last]) &&
+                           material->is_batchable_with(*meshes[last]->get_material())) {
+                        ++last;
+                    }
+                }
+
+                if (last - first > 1) {
+                    SpriteBatch sprite_batch{first, last - first, _sprite_indices.size(), 0};
+                    glm::mat3 inverse_texture1_transformation{
+                        glm::inverse(_get_texture_transformation(material->get_primary_texture()))
+                    };
+                    glm::mat3 inverse_texture2_transformation{
+                        glm::inverse(_get_texture_transformation(material->get_secondary_texture()))
+                    };
+                    for (size_t i = first; i < last; ++i) {
+                        _append_sprite(*meshes[i], inverse_texture1_transformation, inverse_texture2_transformation);
+                    }
+                    sprite_batch.index_count = _sprite_indices.size() - sprite_batch.first_index;
+                    _sprite_batches.push_back(sprite_batch);
+                }
+
+                first = last;
+            }
+
+            if (_sprite_batches.empty()) {
+                return;
+            }
+
+            auto &state = ES2State::get_instance();
+            if (_sprite_vertex_array_object == 0) {
+#ifdef __APPLE__
+                glGenVertexArraysAPPLE(1, &_sprite_vertex_array_object);
+#else
+                glGenVertexArrays(1, &_sprite_vertex_array_object);
+#endif
+                glGenBuffers(1, &_sprite_vertex_buffer_object);
+                glGenBuffers(1, &_sprite_index_buffer_object);
+            }
+            state.bind_vertex_array(_sprite_vertex_array_object);
+
+            auto vertex_data_size = static_cast<GLsizeiptr>(_sprite_vertices.size() * sizeof(Vertex));
+            glBindBuffer(GL_ARRAY_BUFFER, _sprite_vertex_buffer_object);
+            glBufferData(GL_ARRAY_BUFFER, vertex_data_size, nullptr, GL_STREAM_DRAW);
+            glBufferSubData(GL_ARRAY_BUFFER, 0, vertex_data_size, _sprite_vertices.data());
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+            _sprite_index_type = Geometry::get_smallest_index_type(static_cast<unsigned int>(_sprite_vertices.size() - 1));
+            const void *index_data = _sprite_indices.data();
+            if (_sprite_index_type == Geometry::IndexType::UnsignedShortIndices) {
+                _sprite_short_indices.assign(std::begin(_sprite_indices), std::end(_sprite_indices));
+                index_data = _sprite_short_indices.data();
+            }
+
+            auto index_data_size = static_cast<GLsizeiptr>(_sprite_indices.size() * Geometry::get_index_size(_sprite_index_type));
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _sprite_index_buffer_object);
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, index_data_size, nullptr, GL_STREAM_DRAW);
+            glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, index_data_size, index_data);
+        }
+
+        void _append_sprite(
+            Mesh &mesh, const glm::mat3 &inverse_texture1_transformation, const glm::mat3 &inverse_texture2_transformation
+        )
+        {
+            const auto &geometry = mesh.get_geometry();
+            const auto &material = mesh.get_material();
+            glm::mat3 texture1_transformation{
+                inverse_texture1_transformation * _get_texture_transformation(material->get_primary_texture())
+            };
+            glm::mat3 texture2_transformation{
+                inverse_texture2_transformation * _get_texture_transformation(material->get_secondary_texture())
+            };
+
+            auto base = static_cast<unsigned int>(_sprite_vertices.size());
+            ES2StaticBatch::append_indices(geometry->get_type(), geometry->get_indices(), base, _sprite_indices);
+
+            _sprite_mesh_vertices.assign(std::begin(geometry->get_vertices()), std::end(geometry->get_vertices()));
+            Geometry::transform_vertices(_sprite_mesh_vertices, mesh.get_world_matrix());
+            for (auto &vertex : _sprite_mesh_vertices) {
+                vertex.color *= mesh.get_color();
+
+                glm::vec3 texture1_coordinates{texture1_transformation * glm::vec3{glm::vec2{vertex.texture1_coordinates}, 1.0f}};
+                vertex.texture1_coordinates.x = texture1_coordinates.x;
+                vertex.texture1_coordinates.y = texture1_coordinates.y;
+                glm::vec3 texture2_coordinates{texture2_transformation * glm::vec3{glm::vec2{vertex.texture2_coordinates}, 1.0f}};
+                vertex.texture2_coordinates.x = texture2_coordinates.x;
+                vertex.texture2_coordinates.y = texture2_coordinates.y;
+            }
+            _sprite_vertices.insert(std::end(_sprite_vertices), std::begin(_sprite_mesh_vertices), std::end(_sprite_mesh_vertices));
+        }
+
+        void _render_sprite_batch(const SpriteBatch &sprite_batch)
+        {
+            const auto &material = _visible_transparent_meshes[sprite_batch.first_mesh]->get_material();
+
+            material->use();
+            material->update(_frame_uniforms, _sprite_mesh);
+            if (!material->is_ready()) {
+                return;
+            }
+
+            ES2State::get_instance().bind_vertex_array(_sprite_vertex_array_object);
+            glBindBuffer(GL_ARRAY_BUFFER, _sprite_vertex_buffer_object);
+            ES2Geometry::set_vertex_attribute_pointers(*material->get_shader());
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+            _drawn_mesh_count += sprite_batch.mesh_count;
+            ++_draw_call_count;
+
+            glDrawElements(
+                GL_TRIANGLES,
+                static_cast<GLsizei>(sprite_batch.index_count),
+                _convert_index_type_to_es2_index_type(_sprite_index_type),
+                reinterpret_cast<const GLvoid *>(Geometry::get_index_size(_sprite_index_type) * sprite_batch.first_index)
+            );
+        }
+
+        [[nodiscard]] static bool _is_order_independent(const Material &material)
+        {
+            return !material.is_blending_enabled() && material.is_depth_test_enabled();
+        }
+
+        [[nodiscard]] bool _is_instanceable(const Material &material) const
+        {
+            return _instancing_enabled && material.is_instancing_supported() && _is_order_independent(material);
+        }
+
+        /* Instanced shaders derive the normal matrix by rescaling the model-view columns, which is the inverse transpose
+         * only while the axes stay orthogonal. Meshes sheared by non-uniform scales under rotated parents are drawn
+         * on their own with the exact normal matrix. */
+        [[nodiscard]] static bool _has_orthogonal_axes(const glm::mat4 &world_matrix)
+        {
+            glm::vec3 x{world_matrix[0]}, y{world_matrix[1]}, z{world_matrix[2]};
+            auto orthogonal = [](const glm::vec3 &a, const glm::vec3 &b) {
+                float cosine_numerator{glm::dot(a, b)};
+                return cosine_numerator * cosine_numerator <= 1e-6f * glm::dot(a, a) * glm::dot(b, b);
+            };
+
+            return orthogonal(x, y) && orthogonal(y, z) && orthogonal(z, x);
+        }
+
+        void _group_opaque_meshes()
+        {
+            for (size_t i = 0; i < _instance_group_count; ++i) {
+                _instance_groups[i].clear();
+            }
+            _instance_group_count = 0;
+            _instance_group_indices.clear();
+
+            for (size_t i = 0; i < _visible_opaque_meshes.size(); ++i) {
+                const auto &mesh = _visible_opaque_meshes[i];
+                const auto &geometry = mesh->get_geometry();
+                const auto &material = mesh->get_material();
+
+                // Instances are drawn with their group's first mesh, so groups do not reach across order-dependent meshes.
+                if (!_is_order_independent(*material)) {
+                    _instance_group_indices.clear();
+                }
+
+                size_t group_index{_instance_group_count};
+                if (_is_instanceable(*material) && _has_orthogonal_axes(mesh->get_world_matrix())) {
+                    auto key = std::make_pair(geometry.get(), material.get());
+                    auto entry = _instance_group_indices.find(key);
+                    if (entry != _instance_group_indices.end()) {
+                        group_index = entry->second;
+                    } else {
+                        _instance_group_indices[key] = group_index;
+                    }
+                }
+
+                if (group_index == _instance_group_count) {
+                    if (_instance_groups.size() == _instance_group_count) {
+                        _instance_groups.emplace_back();
+                        _instance_group_first_meshes.emplace_back();
+                    }
+                    _instance_group_first_meshes[group_index] = i;
+                    ++_instance_group_count;
+                }
+                _instance_groups[group_index].push_back(mesh);
+            }
+        }
+
+        void _render_instances(const std::vector<std::shared_ptr<Mesh>> &meshes)
+        {
+            auto geometry = meshes.front()->get_geometry();
+            auto material = meshes.front()->get_material();
+
+            bool instance_attributes_supported{GLEW_ARB_instanced_arrays};
+            material->update_instanced(
+                _frame_uniforms,
+                instance_attributes_supported ? Material::InstanceAttributes : Material::InstanceUniformArrays
+            );
+            if (!material->is_ready()) {
+                return;
+            }
+            material->use();
+
+            _drawn_mesh_count += meshes.size();
+
+            if (!instance_attributes_supported) {
+                _render_instance_copies(meshes);
+                return;
+            }
+
+            geometry->update(*material);
+            geometry->use();
+
+            const auto &shader = material->get_shader();
+            const auto &instance_inputs = material->get_instance_inputs();
+
+            GLenum type{_convert_geometry_type_to_es2_geometry_type(geometry->get_type())};
+            auto index_count = static_cast<GLsizei>(geometry->get_indices().size());
+            GLenum index_type{_convert_index_type_to_es2_index_type(geometry->get_index_type())};
+
+            _instance_data.resize(meshes.size() * _InstanceFloatCount);
+            auto *instance = _instance_data.data();
+            for (const auto &mesh : meshes) {
+                std::copy_n(glm::value_ptr(mesh->get_world_matrix()), 16, instance);
+                std::copy_n(glm::value_ptr(mesh->get_color()), 4, instance + 16);
+                instance += _InstanceFloatCount;
+            }
+
+            if (_instance_buffer_object == 0) {
+                glGenBuffers(1, &_instance_buffer_object);
+            }
+            auto instance_data_size = static_cast<GLsizeiptr>(_instance_data.size() * sizeof(GLfloat));
+            glBindBuffer(GL_ARRAY_BUFFER, _instance_buffer_object);
+            glBufferData(GL_ARRAY_BUFFER, instance_data_size, nullptr, GL_STREAM_DRAW);
+            glBufferSubData(GL_ARRAY_BUFFER, 0, instance_data_size, _instance_data.data());
+
+            GLsizei stride = sizeof(GLfloat) * _InstanceFloatCount;
+            std::array<int, 5> locations{
+                shader->get_attribute_location(instance_inputs.model_matrix_columns[0]),
+                shader->get_attribute_location(instance_inputs.model_matrix_columns[1]),
+                shader->get_attribute_location(instance_inputs.model_matrix_columns[2]),
+                shader->get_attribute_location(instance_inputs.model_matrix_columns[3]),
+                shader->get_attribute_location(instance_inputs.color)
+            };
+            for (size_t i = 0; i < locations.size(); ++i) {
+                if (locations[i] != -1) {
+                    auto location = static_cast<GLuint>(locations[i]);
+                    glEnableVertexAttribArray(location);
+                    glVertexAttribPointer(
+                        location, 4, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<const GLvoid *>(sizeof(GLfloat) * 4 * i)
+                    );
+                    glVertexAttribDivisorARB(location, 1);
+                }
+            }
+
+            ++_draw_call_count;
+            glDrawElementsInstancedARB(type, index_count, index_type, nullptr, static_cast<GLsizei>(meshes.size()));
+
+            for (int location : locations) {
+                if (location != -1) {
+                    glVertexAttribDivisorARB(static_cast<GLuint>(location), 0);
+                    glDisableVertexAttribArray(static_cast<GLuint>(location));
+                }
+            }
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+        }
+
+        void _render_instance_copies(const std::vector<std::shared_ptr<Mesh>> &meshes)
+        {
+            const auto &geometry = meshes.front()->get_geometry();
+            const auto &material = meshes.front()->get_material();
+            const auto &shader_pointer = material->get_shader();
+            auto &shader = *shader_pointer;
+            const auto &instance_inputs = material->get_instance_inputs();
+
+            auto &copies = _instance_copies[InstanceCopiesKey{geometry, shader_pointer}];
+            _update_instance_copies(copies, *geometry, shader, instance_inputs);
+            if (copies.copy_count == 0) {
+                return;
+            }
+
+            ES2State::get_instance().bind_vertex_array(copies.vertex_array_object);
+            if (copies.generic_color_location != -1) {
+                glVertexAttrib4f(static_cast<GLuint>(copies.generic_color_location), 1.0f, 1.0f, 1.0f, 1.0f);
+            }
+
+            GLenum type{_convert_geometry_type_to_es2_geometry_type(copies.type)};
+            GLenum index_type{_convert_index_type_to_es2_index_type(copies.index_type)};
+
+            for (size_t first = 0; first < meshes.size(); first += copies.copy_count) {
+                size_t count{std::min(copies.copy_count, meshes.size() - first)};
+
+                _instance_matrices.clear();
+                _instance_colors.clear();
+                for (size_t i = first; i < first + count; ++i) {
+                    _instance_matrices.push_back(meshes[i]->get_world_matrix());
+                    _instance_colors.push_back(meshes[i]->get_color());
+                }
+                shader.set_uniform(instance_inputs.model_matrices, _instance_matrices.data(), count);
+                shader.set_uniform(instance_inputs.colors, _instance_colors.data(), count);
+
+                ++_draw_call_count;
+                glDrawElements(type, static_cast<GLsizei>(copies.copy_index_count * count), index_type, nullptr);
+            }
+        }
+
+        void _update_instance_copies(
+            InstanceCopies &copies, const Geometry &geometry, const Shader &shader, const Material::InstanceInputs &instance_inputs
+        )
+        {
+            if (copies.geometry_version == geometry.get_version()) {
+                return;
+            }
+            copies.geometry_version = geometry.get_version();
+
+            const auto &vertices = geometry.get_vertices();
+            size_t vertex_count{vertices.size()};
+            copies.copy_count = vertex_count == 0 ? 0 : std::clamp(
+                _InstanceCopiesMaxVertexCount / vertex_count, size_t{1}, Material::InstanceUniformArraySize
+            );
+            if (copies.copy_count == 0) {
+                return;
+            }
+
+            VertexLayout vertex_layout{
+                GLEW_ARB_half_float_vertex || GLEW_VERSION_3_0 ?
+                    geometry.get_vertex_layout() :
+                    geometry.get_vertex_layout().replace_component_type(VertexLayout::HalfFloat, VertexLayout::Float)
+            };
+            size_t copy_size{vertex_count * vertex_layout.get_stride()};
+            _instance_copy_vertex_data.resize(copy_size * copies.copy_count);
+            vertex_layout.pack(vertices, 0, vertex_count, _instance_copy_vertex_data.data());
+            _instance_copy_slots.resize(vertex_count * copies.copy_count);
+            _instance_copy_indices.clear();
+            for (size_t i = 0; i < copies.copy_count; ++i) {
+                if (i > 0) {
+                    std::copy_n(
+                        _instance_copy_vertex_data.data(), copy_size, _instance_copy_vertex_data.data() + copy_size * i
+                    );
+                }
+                std::fill_n(_instance_copy_slots.data() + vertex_count * i, vertex_count, static_cast<GLfloat>(i));
+                ES2StaticBatch::append_indices(
+                    geometry.get_type(), geometry.get_indices(), static_cast<unsigned int>(vertex_count * i),
+                    _instance_copy_indices
+                );
+            }
+            copies.type = ES2StaticBatch::get_batch_type(geometry.get_type());
+            copies.copy_index_count = _instance_copy_indices.size() / copies.copy_count;
+
+            copies.index_type = Geometry::get_smallest_index_type(static_cast<unsigned int>(vertex_count * copies.copy_count - 1));
+            const void *index_data = _instance_copy_indices.data();
+            if (copies.index_type == Geometry::IndexType::UnsignedShortIndices) {
+                _instance_copy_short_indices.assign(std::begin(_instance_copy_indices), std::end(_instance_copy_indices));
+                index_data = _instance_copy_short_indices.data();
+            }
+
+            auto &state = ES2State::get_instance();
+            if (copies.vertex_array_object == 0) {
+#ifdef __APPLE__
+                glGenVertexArraysAPPLE(1, &copies.vertex_array_object);
+#else
+                glGenVertexArrays(1, &copies.vertex_array_object);
+#endif
+                glGenBuffers(1, &copies.vertex_buffer_object);
+                glGenBuffers(1, &copies.instance_index_buffer_object);
+                glGenBuffers(1, &copies.index_buffer_object);
+            }
+            state.bind_vertex_array(copies.vertex_array_object);
+
+            glBindBuffer(GL_ARRAY_BUFFER, copies.vertex_buffer_object);
+            glBufferData(
+                GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(_instance_copy_vertex_data.size()),
+                _instance_copy_vertex_data.data(), GL_STATIC_DRAW
+            );
+            ES2Geometry::set_vertex_attribute_pointers(shader, vertex_layout);
+
+            glBindBuffer(GL_ARRAY_BUFFER, copies.instance_index_buffer_object);
+            glBufferData(
+                GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(_instance_copy_slots.size() * sizeof(GLfloat)),
+                _instance_copy_slots.data(), GL_STATIC_DRAW
+            );
+            int instance_index_location{shader.get_attribute_location(instance_inputs.index)};
+            if (instance_index_location != -1) {
+                glEnableVertexAttribArray(static_cast<GLuint>(instance_index_location));
+                glVertexAttribPointer(static_cast<GLuint>(instance_index_location), 1, GL_FLOAT, GL_FALSE, 0, nullptr);
+            }
+
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, copies.index_buffer_object);
+            glBufferData(
+                GL_ELEMENT_ARRAY_BUFFER,
+                static_cast<GLsizeiptr>(_instance_copy_indices.size() * Geometry::get_index_size(copies.index_type)),
+                index_data, GL_STATIC_DRAW
+            );
+
+            copies.generic_color_location =
+                vertex_layout.has(VertexLayout::Color) ? -1 : shader.get_attribute_location(instance_inputs.vertex_color);
+
+            state.bind_vertex_array(0);
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+        }
+
+        void _release_expired_instance_copies()
+        {
+            for (auto entry = _instance_copies.begin(); entry != _instance_copies.end();) {
+                if (entry->first.first.expired() || entry->first.second.expired()) {
+                    _delete_instance_copies(entry->second);
+                    entry = _instance_copies.erase(entry);
+                } else {
+                    ++entry;
+                }
+            }
+        }
+
+        static void _delete_instance_copies(InstanceCopies &copies)
+        {
+            if (copies.vertex_array_object == 0) {
+                return;
+            }
+
+            ES2State::get_instance().on_vertex_array_deleted(copies.vertex_array_object);
+#ifdef __APPLE__
+            glDeleteVertexArraysAPPLE(1, &copies.vertex_array_object);
+#else
+            glDeleteVertexArrays(1, &copies.vertex_array_object);
+#endif
+            glDeleteBuffers(1, &copies.vertex_buffer_object);
+            glDeleteBuffers(1, &copies.instance_index_buffer_object);
+            glDeleteBuffers(1, &copies.index_buffer_object);
+        }
+
+        void _render_mesh(
+            const std::shared_ptr<Mesh> &mesh, size_t mesh_count = 1, const FrameUniforms::DrawData *draw_data = nullptr
+        )
         {
             auto geometry = mesh->get_geometry();
             auto material = mesh->get_material();
 
             material->use();
-            material->update(scene, mesh);
+            _frame_uniforms.set_draw_data(draw_data);
+            material->update(_frame_uniforms, mesh);
+            _frame_uniforms.set_draw_data(nullptr);
+            if (!material->is_ready()) {
+                return;
+            }
             geometry->update(*material);
             geometry->use();
 
+            _drawn_mesh_count += mesh_count;
+            ++_draw_call_count;
+
             glDrawElements(
                 _convert_geometry_type_to_es2_geometry_type(geometry->get_type()),
                 static_cast<GLsizei>(geometry->get_indices().size()),
-                GL_UNSIGNED_INT,
+                _convert_index_type_to_es2_index_type(geometry->get_index_type()),
                 nullptr
             );
         }
 
+        static GLenum _convert_index_type_to_es2_index_type(Geometry::IndexType index_type)
+        {
+            switch (index_type) {
+                case Geometry::IndexType::UnsignedByteIndices:
+                    return GL_UNSIGNED_BYTE;
+                case Geometry::IndexType::UnsignedShortIndices:
+                    return GL_UNSIGNED_SHORT;
+                case Geometry::IndexType::UnsignedIntIndices:
+                    return GL_UNSIGNED_INT;
+            }
+
+            return GL_UNSIGNED_INT;
+        }
+
         static GLenum _convert_geometry_type_to_es2_geometry_type(Geometry::Type type)
         {
             switch (type) {
@@ -2,15 +2,22 @@
 #define ES2_SHADER_H
 
 #include "renderer/shader.h"
+#include "renderer/es2_state.h"
+#include "utilities/utilities.h"
 
 #include <GL/glew.h>
 #define SDL_MAIN_HANDLED
 #include <SDL.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
 
 #include <string>
 #include <vector>
+#include <map>
 #include <iostream>
 #include <cstdlib>
+#include <cstdint>
+#include <cstdio>
 
 namespace asr
 {
@@ -18,7 +25,7 @@ namespace asr
     {
     public:
         ES2Shader(const std::string &vertex_shader_source, const std::string &fragment_shader_source,
-                  const std::vector<std::string> &attributes, const std::vector<std::string> &uniforms)
+                  const std::vector<std::string> &attributes = {}, const std::vector<std::string> &uniforms = {})
             : Shader(vertex_shader_source, fragment_shader_source, attributes, uniforms)
         {}
 
@@ -27,39 +34,90 @@ namespace asr
 
         ~ES2Shader() final
         {
+            if (_compiling) {
+                _delete_pending_objects();
+            }
             if (_program != -1) {
+                ES2State::get_instance().on_program_deleted(static_cast<GLuint>(_program));
                 glDeleteProgram(static_cast<GLuint>(_program));
             }
         }
 
-        void compile() final
+        [[nodiscard]] static const std::string &get_program_binary_cache_directory()
         {
-            cleanup();
+            return _program_binary_cache_directory;
+        }
 
-            int vertex_shader_object = _compile_shader(GL_VERTEX_SHADER);
-            if (vertex_shader_object == -1) {
-                _dead = true;
+        static void set_program_binary_cache_directory(const std::string &program_binary_cache_directory)
+        {
+            _program_binary_cache_directory = program_binary_cache_directory;
+        }
+
+        [[nodiscard]] static bool is_asynchronous_compilation_enabled()
+        {
+            return _asynchronous_compilation_enabled;
+        }
+
+        /* When enabled, compile() returns before the program is linked and later calls finish it once it is ready.
+         * With KHR/ARB_parallel_shader_compile the driver builds programs in the background and nothing blocks.
+         * Without it the avoidance is best effort: the shaders are compiled on one frame and the program is linked
+         * on a later one, each stage blocking the render thread and counting against the per-frame budget. */
+        static void set_asynchronous_compilation_enabled(bool asynchronous_compilation_enabled)
+        {
+            _asynchronous_compilation_enabled = asynchronous_compilation_enabled;
+        }
+
+        [[nodiscard]] static size_t get_blocking_compilations_per_frame()
+        {
+            return _blocking_compilations_per_frame;
+        }
+
+        // The number of blocking compile or link stages run per frame when parallel compilation is unavailable.
+        static void set_blocking_compilations_per_frame(size_t blocking_compilations_per_frame)
+        {
+            _blocking_compilations_per_frame = blocking_compilations_per_frame;
+        }
+
+        static void begin_frame()
+        {
+            _remaining_blocking_compilations = _blocking_compilations_per_frame;
+        }
+
+        void compile() final
+        {
+            if (_compiling) {
+                _continue_compilation();
                 return;
             }
 
-            int fragment_shader_object = _compile_shader(GL_FRAGMENT_SHADER);
-            if (fragment_shader_object == -1) {
-                _dead = true;
+            cleanup();
+
+            if (_load_program_binary()) {
                 return;
             }
 
-            int shader_program = _link_shader(static_cast<GLuint>(vertex_shader_object), static_cast<GLuint>(fragment_shader_object));
-            if (shader_program == -1) {
-                _dead = true;
+            _compiling = true;
+            if (_asynchronous_compilation_enabled && !_is_parallel_compilation_supported()) {
+                _continue_compilation();
                 return;
             }
 
-            _program = shader_program;
+            _pending_vertex_shader_object = _create_shader(GL_VERTEX_SHADER);
+            _pending_fragment_shader_object = _create_shader(GL_FRAGMENT_SHADER);
+            _pending_program = _create_program(_pending_vertex_shader_object, _pending_fragment_shader_object);
+
+            if (!_asynchronous_compilation_enabled) {
+                _finish_compilation();
+            }
         }
 
         void cleanup() final
         {
+            if (_compiling) {
+                _delete_pending_objects();
+            }
             if (_program != -1) {
+                ES2State::get_instance().on_program_deleted(static_cast<GLuint>(_program));
                 glDeleteProgram(static_cast<GLuint>(_program));
             }
             _program = -1;
@@ -69,12 +127,111 @@ namespace asr
         void use() final
         {
             if (_program != -1) {
-                glUseProgram(static_cast<GLuint>(_program));
+                ES2State::get_instance().use_program(static_cast<GLuint>(_program));
+            }
+        }
+
+        void set_uniform(Uniform uniform, int value) final
+        {
+            if (_uniform_value_requires_upload(uniform, &value, sizeof(GLint))) {
+                glUniform1i(_uniform_locations[static_cast<size_t>(uniform.slot)], value);
+            }
+        }
+
+        void set_uniform(Uniform uniform, float value) final
+        {
+            if (_uniform_value_requires_upload(uniform, &value, sizeof(GLfloat))) {
+                glUniform1f(_uniform_locations[static_cast<size_t>(uniform.slot)], value);
+            }
+        }
+
+        void set_uniform(Uniform uniform, const glm::vec3 &value) final
+        {
+            if (_uniform_value_requires_upload(uniform, glm::value_ptr(value), sizeof(GLfloat) * 3)) {
+                glUniform3fv(_uniform_locations[static_cast<size_t>(uniform.slot)], 1, glm::value_ptr(value));
+            }
+        }
+
+        void set_uniform(Uniform uniform, const glm::vec4 &value) final
+        {
+            if (_uniform_value_requires_upload(uniform, glm::value_ptr(value), sizeof(GLfloat) * 4)) {
+                glUniform4fv(_uniform_locations[static_cast<size_t>(uniform.slot)], 1, glm::value_ptr(value));
+            }
+        }
+
+        void set_uniform(Uniform uniform, const glm::mat3 &value) final
+        {
+            if (_uniform_value_requires_upload(uniform, glm::value_ptr(value), sizeof(GLfloat) * 9)) {
+                glUniformMatrix3fv(_uniform_locations[static_cast<size_t>(uniform.slot)], 1, GL_FALSE, glm::value_ptr(value));
+            }
+        }
+
+        void set_uniform(Uniform uniform, const glm::mat4 &value) final
+        {
+            if (_uniform_value_requires_upload(uniform, glm::value_ptr(value), sizeof(GLfloat) * 16)) {
+                glUniformMatrix4fv(_uniform_locations[static_cast<size_t>(uniform.slot)], 1, GL_FALSE, glm::value_ptr(value));
+            }
+        }
+
+        void set_uniform(Uniform uniform, const glm::vec4 *values, size_t count) final
+        {
+            if (_uniform_array_requires_upload(uniform, count)) {
+                glUniform4fv(
+                    _uniform_locations[static_cast<size_t>(uniform.slot)], static_cast<GLsizei>(count),
+                    glm::value_ptr(values[0])
+                );
+            }
+        }
+
+        void set_uniform(Uniform uniform, const glm::mat4 *values, size_t count) final
+        {
+            if (_uniform_array_requires_upload(uniform, count)) {
+                glUniformMatrix4fv(
+                    _uniform_locations[static_cast<size_t>(uniform.slot)], static_cast<GLsizei>(count), GL_FALSE,
+                    glm::value_ptr(values[0])
+                );
             }
         }
 
     private:
-        int _compile_shader(GLenum shader_type)
+        inline static const std::map<std::string, GLuint> _reserved_attribute_locations{
+            {"position", 0},
+            {"color", 1},
+            {"normal", 2},
+            {"tangent", 3},
+            {"binormal", 4},
+            {"texture1_coordinates", 5},
+            {"texture2_coordinates", 6},
+            {"instance_model_matrix_column0", 7},
+            {"instance_model_matrix_column1", 8},
+            {"instance_model_matrix_column2", 9},
+            {"instance_model_matrix_column3", 10},
+            {"instance_color", 11},
+            // Only used by shaders that read instances from uniform arrays, which have no per-instance attributes.
+            {"instance_index", 7}
+        };
+
+        inline static std::string _program_binary_cache_directory;
+
+        inline static bool _asynchronous_compilation_enabled{false};
+        inline static size_t _blocking_compilations_per_frame{1};
+        inline static size_t _remaining_blocking_compilations{1};
+
+        GLuint _pending_vertex_shader_object{0};
+        GLuint _pending_fragment_shader_object{0};
+        GLuint _pending_program{0};
+
+        [[nodiscard]] int _find_attribute_location(const std::string &name) const final
+        {
+            return glGetAttribLocation(static_cast<GLuint>(_program), name.c_str());
+        }
+
+        [[nodiscard]] int _find_uniform_location(const std::string &name) const final
+        {
+            return glGetUniformLocation(static_cast<GLuint>(_program), name.c_str());
+        }
+
+        GLuint _create_shader(GLenum shader_type)
         {
             const char *shader_source =
                 shader_type == GL_VERTEX_SHADER ?
@@ -85,6 +242,109 @@ namespace asr
             glShaderSource(shader_object, 1, static_cast<const GLchar **>(&shader_source), nullptr);
             glCompileShader(shader_object);
 
+            return shader_object;
+        }
+
+        GLuint _create_program(GLuint vertex_shader_object, GLuint fragment_shader_object) const
+        {
+            GLuint shader_program = glCreateProgram();
+            glAttachShader(shader_program, vertex_shader_object);
+            glAttachShader(shader_program, fragment_shader_object);
+            for (const auto &attribute_name : _attribute_names) {
+                auto attribute_location = _reserved_attribute_locations.find(attribute_name);
+                if (attribute_location != _reserved_attribute_locations.end()) {
+                    glBindAttribLocation(shader_program, attribute_location->second, attribute_name.c_str());
+                }
+            }
+            if (_is_program_binary_cache_enabled()) {
+                glProgramParameteri(shader_program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+            }
+            glLinkProgram(shader_program);
+
+            return shader_program;
+        }
+
+        static bool _is_parallel_compilation_supported()
+        {
+            return GLEW_KHR_parallel_shader_compile || GLEW_ARB_parallel_shader_compile;
+        }
+
+        void _continue_compilation()
+        {
+            if (_is_parallel_compilation_supported()) {
+                GLint completed{GL_FALSE};
+                glGetProgramiv(_pending_program, GL_COMPLETION_STATUS_KHR, &completed);
+                if (completed == GL_FALSE) {
+                    return;
+                }
+
+                _finish_compilation();
+                return;
+            }
+
+            if (_remaining_blocking_compilations == 0) {
+                return;
+            }
+            --_remaining_blocking_compilations;
+
+            // Querying the status waits for the compiler, so the shaders are finished here and linked on a later frame.
+            if (_pending_vertex_shader_object == 0) {
+                _pending_vertex_shader_object = _create_shader(GL_VERTEX_SHADER);
+                _pending_fragment_shader_object = _create_shader(GL_FRAGMENT_SHADER);
+                if (!_check_shader(_pending_vertex_shader_object, GL_VERTEX_SHADER) ||
+                    !_check_shader(_pending_fragment_shader_object, GL_FRAGMENT_SHADER)) {
+                    _delete_pending_objects();
+                    _dead = true;
+                }
+                return;
+            }
+
+            _pending_program = _create_program(_pending_vertex_shader_object, _pending_fragment_shader_object);
+            _finish_compilation();
+        }
+
+        void _finish_compilation()
+        {
+            bool compiled =
+                _check_shader(_pending_vertex_shader_object, GL_VERTEX_SHADER) &&
+                _check_shader(_pending_fragment_shader_object, GL_FRAGMENT_SHADER) &&
+                _check_program(_pending_program);
+            if (!compiled) {
+                _delete_pending_objects();
+                _dead = true;
+                return;
+            }
+
+            glDetachShader(_pending_program, _pending_vertex_shader_object);
+            glDetachShader(_pending_program, _pending_fragment_shader_object);
+            glDeleteShader(_pending_vertex_shader_object);
+            glDeleteShader(_pending_fragment_shader_object);
+
+            _resolve_locations(_pending_program);
+
+            _program = static_cast<int>(_pending_program);
+            _pending_vertex_shader_object = 0;
+            _pending_fragment_shader_object = 0;
+            _pending_program = 0;
+            _compiling = false;
+            _forget_uniform_values();
+
+            _save_program_binary();
+        }
+
+        void _delete_pending_objects()
+        {
+            glDeleteProgram(_pending_program);
+            glDeleteShader(_pending_vertex_shader_object);
+            glDeleteShader(_pending_fragment_shader_object);
+            _pending_vertex_shader_object = 0;
+            _pending_fragment_shader_object = 0;
+            _pending_program = 0;
+            _compiling = false;
+        }
+
+        static bool _check_shader(GLuint shader_object, GLenum shader_type)
+        {
             GLint status;
             glGetShaderiv(shader_object, GL_COMPILE_STATUS, &status);
             if (status == GL_FALSE) {
@@ -94,24 +354,20 @@ namespace asr
                     auto *info_log = new GLchar[static_cast<size_t>(info_log_length)];
 
                     glGetShaderInfoLog(shader_object, info_log_length, nullptr, info_log);
-                    std::cerr << "Failed to compile a vertex shader" << std::endl
+                    std::cerr << "Failed to compile a " << (shader_type == GL_VERTEX_SHADER ? "vertex" : "fragment")
+                              << " shader" << std::endl
                               << "Compilation log:\n" << info_log << std::endl << std::endl;
 
                     delete[] info_log;
                 }
-                return _program = -1;
+                return false;
             }
 
-            return static_cast<int>(shader_object);
+            return true;
         }
 
-        int _link_shader(GLuint vertex_shader_object, GLuint fragment_shader_object)
+        static bool _check_program(GLuint shader_program)
         {
-            GLuint shader_program = glCreateProgram();
-            glAttachShader(shader_program, vertex_shader_object);
-            glAttachShader(shader_program, fragment_shader_object);
-            glLinkProgram(shader_program);
-
             GLint status;
             glGetProgramiv(shader_program, GL_LINK_STATUS, &status);
             if (status == GL_FALSE) {
@@ -126,22 +382,154 @@ namespace asr
 
                     delete[] info_log;
                 }
-                return _program = -1;
+                return false;
+            }
+
+            return true;
+        }
+
+        void _resolve_locations(GLuint shader_program)
+        {
+            for (std::vector<std::string>::size_type i = 0; i < _attribute_names.size(); ++i) {
+                _attribute_locations[i] = glGetAttribLocation(shader_program, _attribute_names[i].c_str());
+            }
+            for (std::vector<std::string>::size_type i = 0; i < _uniform_names.size(); ++i) {
+                _uniform_locations[i] = glGetUniformLocation(shader_program, _uniform_names[i].c_str());
+            }
+        }
+
+        static bool _is_program_binary_cache_enabled()
+        {
+            if (_program_binary_cache_directory.empty() || !GLEW_ARB_get_program_binary) {
+                return false;
+            }
+
+            GLint binary_format_count{0};
+            glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &binary_format_count);
+
+            return binary_format_count > 0;
+        }
+
+        static uint64_t _hash(const std::string &data, uint64_t hash = 14695981039346656037ULL)
+        {
+            for (auto character : data) {
+                hash ^= static_cast<uint8_t>(character);
+                hash *= 1099511628211ULL;
             }
 
-            glDetachShader(shader_program, vertex_shader_object);
-            glDetachShader(shader_program, fragment_shader_object);
-            glDeleteShader(vertex_shader_object);
-            glDeleteShader(fragment_shader_object);
+            return hash;
+        }
 
-            for (auto const &attribute : _attributes) {
-                _attributes[attribute.first] = glGetAttribLocation(shader_program, attribute.first.c_str());
+        static std::string _get_driver_identifier()
+        {
+            std::string driver_identifier;
+            for (GLenum name : {GL_VENDOR, GL_RENDERER, GL_VERSION}) {
+                const auto *value = reinterpret_cast<const char *>(glGetString(name));
+                driver_identifier += value ? value : "";
+                driver_identifier += '\n';
             }
-            for (auto const &uniform : _uniforms) {
-                _uniforms[uniform.first] = glGetUniformLocation(shader_program, uniform.first.c_str());
+
+            return driver_identifier;
+        }
+
+        [[nodiscard]] std::string _get_program_binary_path(const std::string &driver_identifier) const
+        {
+            uint64_t hash = _hash(_vertex_shader_source);
+            hash = _hash(std::string(1, '\0'), hash);
+            hash = _hash(_fragment_shader_source, hash);
+            for (const auto &attribute_name : _attribute_names) {
+                hash = _hash(std::string(1, '\0') + attribute_name, hash);
             }
+            hash = _hash(std::string(1, '\0') + driver_identifier, hash);
+
+            char file_name[32];
+            std::snprintf(file_name, sizeof(file_name), "%016llx.bin", static_cast<unsigned long long>(hash));
 
-            return static_cast<int>(shader_program);
+            return _program_binary_cache_directory + "/" + file_name;
+        }
+
+        bool _load_program_binary()
+        {
+            if (!_is_program_binary_cache_enabled()) {
+                return false;
+            }
+
+            auto driver_identifier = _get_driver_identifier();
+            auto path = _get_program_binary_path(driver_identifier);
+
+            std::vector<uint8_t> data;
+            if (!file_utilities::read_binary_file(path, data)) {
+                return false;
+            }
+
+            size_t header_size = sizeof(uint32_t) * 2 + driver_identifier.size();
+            if (data.size() <= header_size ||
+                std::memcmp(data.data() + sizeof(uint32_t) * 2, driver_identifier.data(), driver_identifier.size()) != 0) {
+                std::remove(path.c_str());
+                return false;
+            }
+
+            uint32_t binary_format, driver_identifier_size;
+            std::memcpy(&binary_format, data.data(), sizeof(uint32_t));
+            std::memcpy(&driver_identifier_size, data.data() + sizeof(uint32_t), sizeof(uint32_t));
+            if (driver_identifier_size != driver_identifier.size()) {
+                std::remove(path.c_str());
+                return false;
+            }
+
+            GLuint shader_program = glCreateProgram();
+            glProgramBinary(
+                shader_program, static_cast<GLenum>(binary_format),
+                data.data() + header_size, static_cast<GLsizei>(data.size() - header_size)
+            );
+
+            GLint status;
+            glGetProgramiv(shader_program, GL_LINK_STATUS, &status);
+            if (status == GL_FALSE) {
+                glDeleteProgram(shader_program);
+                std::remove(path.c_str());
+                return false;
+            }
+
+            _resolve_locations(shader_program);
+            _program = static_cast<int>(shader_program);
+            _forget_uniform_values();
+
+            return true;
+        }
+
+        void _save_program_binary() const
+        {
+            if (!_is_program_binary_cache_enabled()) {
+                return;
+            }
+
+            GLint binary_length{0};
+            glGetProgramiv(static_cast<GLuint>(_program), GL_PROGRAM_BINARY_LENGTH, &binary_length);
+            if (binary_length <= 0) {
+                return;
+            }
+
+            auto driver_identifier = _get_driver_identifier();
+            size_t header_size = sizeof(uint32_t) * 2 + driver_identifier.size();
+
+            std::vector<uint8_t> data(header_size + static_cast<size_t>(binary_length));
+            GLenum binary_format{0};
+            glGetProgramBinary(
+                static_cast<GLuint>(_program), binary_length, nullptr,
+                &binary_format, data.data() + header_size
+            );
+
+            auto stored_binary_format = static_cast<uint32_t>(binary_format);
+            auto driver_identifier_size = static_cast<uint32_t>(driver_identifier.size());
+            std::memcpy(data.data(), &stored_binary_format, sizeof(uint32_t));
+            std::memcpy(data.data() + sizeof(uint32_t), &driver_identifier_size, sizeof(uint32_t));
+            std::memcpy(data.data() + sizeof(uint32_t) * 2, driver_identifier.data(), driver_identifier.size());
+
+            if (!file_utilities::write_binary_file(_get_program_binary_path(driver_identifier), data)) {
+                std::cerr << "Failed to write a program binary to the cache directory: '"
+                          << _program_binary_cache_directory << "'" << std::endl;
+            }
         }
     };
 }
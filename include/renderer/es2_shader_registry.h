@@ -0,0 +1,109 @@
+#ifndef ES2_SHADER_REGISTRY_H
+#define ES2_SHADER_REGISTRY_H
+
+#include "renderer/es2_shader.h"
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+
+namespace asr
+{
+    class ES2ShaderRegistry final
+    {
+    public:
+        static ES2ShaderRegistry &get_instance()
+        {
+            static ES2ShaderRegistry instance;
+
+            return instance;
+        }
+
+        ES2ShaderRegistry(const ES2ShaderRegistry &other) = delete;
+        ES2ShaderRegistry& operator=(const ES2ShaderRegistry &other) = delete;
+
+        std::shared_ptr<ES2Shader> get_shader(
+            const std::string &vertex_shader_source, const std::string &fragment_shader_source,
+            const std::vector<std::string> &attributes = {}, const std::vector<std::string> &uniforms = {},
+            const std::string &defines = ""
+        )
+        {
+            // The lists decide which attribute and uniform handles a shader hands out, so shaders built from the
+            // same sources with different lists cannot be shared.
+            std::string key{defines + '\0' + vertex_shader_source + '\0' + fragment_shader_source};
+            for (const auto *names : {&attributes, &uniforms}) {
+                key += '\0';
+                for (const auto &name : *names) {
+                    key += name + ',';
+                }
+            }
+
+            auto entry = _shaders.find(key);
+            if (entry != _shaders.end()) {
+                if (auto shader = entry->second.lock()) {
+                    return shader;
+                }
+            }
+
+            remove_unused_shaders();
+
+            auto shader = std::make_shared<ES2Shader>(
+                _insert_defines(vertex_shader_source, defines),
+                _insert_defines(fragment_shader_source, defines),
+                attributes, uniforms
+            );
+            _shaders[key] = shader;
+
+            return shader;
+        }
+
+        [[nodiscard]] size_t get_shader_count() const
+        {
+            size_t shader_count{0};
+            for (const auto &entry : _shaders) {
+                if (!entry.second.expired()) {
+                    ++shader_count;
+                }
+            }
+
+            return shader_count;
+        }
+
+        void remove_unused_shaders()
+        {
+            for (auto entry = _shaders.begin(); entry != _shaders.end();) {
+                if (entry->second.expired()) {
+                    entry = _shaders.erase(entry);
+                } else {
+                    ++entry;
+                }
+            }
+        }
+
+    private:
+        std::unordered_map<std::string, std::weak_ptr<ES2Shader>> _shaders;
+
+        ES2ShaderRegistry() = default;
+
+        static std::string _insert_defines(const std::string &source, const std::string &defines)
+        {
+            if (defines.empty()) {
+                return source;
+            }
+
+            if (source.compare(0, 8, "#version") == 0) {
+                auto version_end = source.find('\n');
+                if (version_end == std::string::npos) {
+                    return source + "\n" + defines;
+                }
+
+                return source.substr(0, version_end + 1) + defines + source.substr(version_end + 1);
+            }
+
+            return defines + source;
+        }
+    };
+}
+
+#endif
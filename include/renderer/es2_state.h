@@ -0,0 +1,280 @@
+#ifndef ES2_STATE_H
+#define ES2_STATE_H
+
+#include <GL/glew.h>
+#define SDL_MAIN_HANDLED
+#include <SDL.h>
+#include <glm/glm.hpp>
+
+#include <array>
+#include <cmath>
+
+namespace asr
+{
+    class ES2State final
+    {
+    public:
+        static ES2State &get_instance()
+        {
+            static ES2State instance;
+
+            return instance;
+        }
+
+        ES2State(const ES2State &other) = delete;
+        ES2State& operator=(const ES2State &other) = delete;
+
+        void invalidate()
+        {
+            _depth_mask_enabled = _Unknown;
+            _depth_test_enabled = _Unknown;
+            _depth_test_function = _UnknownName;
+
+            _blending_enabled = _Unknown;
+            _color_blending_equation = _UnknownName;
+            _alpha_blending_equation = _UnknownName;
+            _source_color_blending_function = _UnknownName;
+            _destination_color_blending_function = _UnknownName;
+            _source_alpha_blending_function = _UnknownName;
+            _destination_alpha_blending_function = _UnknownName;
+            _blending_constant_color = glm::vec4{NAN};
+
+            _face_culling_enabled = _Unknown;
+            _cull_face_mode = _UnknownName;
+            _front_face_order = _UnknownName;
+
+            _polygon_offset_enabled = _Unknown;
+            _polygon_offset_factor = NAN;
+            _polygon_offset_units = NAN;
+
+            _line_width = NAN;
+
+            _program = _UnknownName;
+            _active_texture_unit = _UnknownName;
+            _textures.fill(_UnknownName);
+            _vertex_array_object = _UnknownName;
+        }
+
+        void set_depth_mask_enabled(bool depth_mask_enabled)
+        {
+            if (_depth_mask_enabled != static_cast<int>(depth_mask_enabled)) {
+                glDepthMask(static_cast<GLboolean>(depth_mask_enabled));
+                _depth_mask_enabled = static_cast<int>(depth_mask_enabled);
+            }
+        }
+
+        void set_depth_test_enabled(bool depth_test_enabled)
+        {
+            _set_capability_enabled(GL_DEPTH_TEST, depth_test_enabled, _depth_test_enabled);
+        }
+
+        void set_depth_test_function(GLenum depth_test_function)
+        {
+            if (_depth_test_function != depth_test_function) {
+                glDepthFunc(depth_test_function);
+                _depth_test_function = depth_test_function;
+            }
+        }
+
+        void set_blending_enabled(bool blending_enabled)
+        {
+            _set_capability_enabled(GL_BLEND, blending_enabled, _blending_enabled);
+        }
+
+        void set_blending_equations(GLenum color_blending_equation, GLenum alpha_blending_equation)
+        {
+            if (_color_blending_equation != color_blending_equation ||
+                _alpha_blending_equation != alpha_blending_equation) {
+                glBlendEquationSeparate(color_blending_equation, alpha_blending_equation);
+                _color_blending_equation = color_blending_equation;
+                _alpha_blending_equation = alpha_blending_equation;
+            }
+        }
+
+        void set_blending_functions(
+            GLenum source_color_blending_function, GLenum destination_color_blending_function,
+            GLenum source_alpha_blending_function, GLenum destination_alpha_blending_function
+        )
+        {
+            if (_source_color_blending_function != source_color_blending_function ||
+                _destination_color_blending_function != destination_color_blending_function ||
+                _source_alpha_blending_function != source_alpha_blending_function ||
+                _destination_alpha_blending_function != destination_alpha_blending_function) {
+                glBlendFuncSeparate(source_color_blending_function, destination_color_blending_function,
+                                    source_alpha_blending_function, destination_alpha_blending_function);
+                _source_color_blending_function = source_color_blending_function;
+                _destination_color_blending_function = destination_color_blending_function;
+                _source_alpha_blending_function = source_alpha_blending_function;
+                _destination_alpha_blending_function = destination_alpha_blending_function;
+            }
+        }
+
+        void set_blending_constant_color(const glm::vec4 &blending_constant_color)
+        {
+            if (_blending_constant_color != blending_constant_color) {
+                glBlendColor(static_cast<GLclampf>(blending_constant_color[0]),
+                             static_cast<GLclampf>(blending_constant_color[1]),
+                             static_cast<GLclampf>(blending_constant_color[2]),
+                             static_cast<GLclampf>(blending_constant_color[3]));
+                _blending_constant_color = blending_constant_color;
+            }
+        }
+
+        void set_face_culling_enabled(bool face_culling_enabled)
+        {
+            _set_capability_enabled(GL_CULL_FACE, face_culling_enabled, _face_culling_enabled);
+        }
+
+        void set_cull_face_mode(GLenum cull_face_mode)
+        {
+            if (_cull_face_mode != cull_face_mode) {
+                glCullFace(cull_face_mode);
+                _cull_face_mode = cull_face_mode;
+            }
+        }
+
+        void set_front_face_order(GLenum front_face_order)
+        {
+            if (_front_face_order != front_face_order) {
+                glFrontFace(front_face_order);
+                _front_face_order = front_face_order;
+            }
+        }
+
+        void set_polygon_offset_enabled(bool polygon_offset_enabled)
+        {
+            _set_capability_enabled(GL_POLYGON_OFFSET_FILL, polygon_offset_enabled, _polygon_offset_enabled);
+        }
+
+        void set_polygon_offset(float polygon_offset_factor, float polygon_offset_units)
+        {
+            if (_polygon_offset_factor != polygon_offset_factor || _polygon_offset_units != polygon_offset_units) {
+                glPolygonOffset(static_cast<GLfloat>(polygon_offset_factor), static_cast<GLfloat>(polygon_offset_units));
+                _polygon_offset_factor = polygon_offset_factor;
+                _polygon_offset_units = polygon_offset_units;
+            }
+        }
+
+        void set_line_width(float line_width)
+        {
+            if (_line_width != line_width) {
+                glLineWidth(static_cast<GLfloat>(line_width));
+                _line_width = line_width;
+            }
+        }
+
+        void use_program(GLuint program)
+        {
+            if (_program != program) {
+                glUseProgram(program);
+                _program = program;
+            }
+        }
+
+        void set_active_texture_unit(unsigned int texture_unit)
+        {
+            if (_active_texture_unit != texture_unit) {
+                glActiveTexture(GL_TEXTURE0 + texture_unit);
+                _active_texture_unit = texture_unit;
+            }
+        }
+
+        void bind_texture(unsigned int texture_unit, GLuint texture)
+        {
+            if (texture_unit >= _textures.size()) {
+                set_active_texture_unit(texture_unit);
+                glBindTexture(GL_TEXTURE_2D, texture);
+            } else if (_textures[texture_unit] != texture) {
+                set_active_texture_unit(texture_unit);
+                glBindTexture(GL_TEXTURE_2D, texture);
+                _textures[texture_unit] = texture;
+            }
+        }
+
+        void bind_vertex_array(GLuint vertex_array_object)
+        {
+            if (_vertex_array_object != vertex_array_object) {
+#ifdef __APPLE__
+                glBindVertexArrayAPPLE(vertex_array_object);
+#else
+                glBindVertexArray(vertex_array_object);
+#endif
+                _vertex_array_object = vertex_array_object;
+            }
+        }
+
+        void on_program_deleted(GLuint program)
+        {
+            if (_program == program) {
+                _program = _UnknownName;
+            }
+        }
+
+        void on_texture_deleted(GLuint texture)
+        {
+            for (auto &bound_texture : _textures) {
+                if (bound_texture == texture) {
+                    bound_texture = _UnknownName;
+                }
+            }
+        }
+
+        void on_vertex_array_deleted(GLuint vertex_array_object)
+        {
+            if (_vertex_array_object == vertex_array_object) {
+                _vertex_array_object = _UnknownName;
+            }
+        }
+
+    private:
+        static constexpr int _Unknown{-1};
+        static constexpr GLuint _UnknownName{~0u};
+
+        int _depth_mask_enabled{_Unknown};
+        int _depth_test_enabled{_Unknown};
+        GLenum _depth_test_function{_UnknownName};
+
+        int _blending_enabled{_Unknown};
+        GLenum _color_blending_equation{_UnknownName};
+        GLenum _alpha_blending_equation{_UnknownName};
+        GLenum _source_color_blending_function{_UnknownName};
+        GLenum _destination_color_blending_function{_UnknownName};
+        GLenum _source_alpha_blending_function{_UnknownName};
+        GLenum _destination_alpha_blending_function{_UnknownName};
+        glm::vec4 _blending_constant_color{NAN};
+
+        int _face_culling_enabled{_Unknown};
+        GLenum _cull_face_mode{_UnknownName};
+        GLenum _front_face_order{_UnknownName};
+
+        int _polygon_offset_enabled{_Unknown};
+        float _polygon_offset_factor{NAN};
+        float _polygon_offset_units{NAN};
+
+        float _line_width{NAN};
+
+        GLuint _program{_UnknownName};
+        GLuint _active_texture_unit{_UnknownName};
+        std::array<GLuint, 16> _textures{};
+        GLuint _vertex_array_object{_UnknownName};
+
+        ES2State()
+        {
+            _textures.fill(_UnknownName);
+        }
+
+        static void _set_capability_enabled(GLenum capability, bool enabled, int &cached_enabled)
+        {
+            if (cached_enabled != static_cast<int>(enabled)) {
+                if (enabled) {
+                    glEnable(capability);
+                } else {
+                    glDisable(capability);
+                }
+                cached_enabled = static_cast<int>(enabled);
+            }
+        }
+    };
+}
+
+#endif
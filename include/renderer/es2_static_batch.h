@@ -0,0 +1,222 @@
+#ifndef ES2_STATIC_BATCH_H
+#define ES2_STATIC_BATCH_H
+
+#include "objects/object.h"
+#include "objects/mesh.h"
+#include "geometries/geometry.h"
+#include "geometries/es2_geometry.h"
+#include "geometries/vertex.h"
+#include "materials/material.h"
+
+#include <glm/glm.hpp>
+
+#include <memory>
+#include <utility>
+#include <vector>
+#include <cstddef>
+
+namespace asr
+{
+    /* Static meshes sharing a parent and a material, pre-transformed into the parent's space and merged into one
+     * geometry. Strips, fans and loops are expanded to lists so that members of different types can share a draw. */
+    class ES2StaticBatch final
+    {
+    public:
+        explicit ES2StaticBatch(std::vector<std::shared_ptr<Mesh>> meshes)
+            : _meshes{std::move(meshes)},
+              _material{_meshes.front()->get_material()},
+              _parent{_meshes.front()->get_parent()},
+              _type{get_batch_type(_meshes.front()->get_geometry()->get_type())}
+        {
+            rebuild();
+        }
+
+        static Geometry::Type get_batch_type(Geometry::Type type)
+        {
+            switch (type) {
+                case Geometry::Type::Points:
+                    return Geometry::Type::Points;
+                case Geometry::Type::Lines:
+                case Geometry::Type::LineLoop:
+                case Geometry::Type::LineStrip:
+                    return Geometry::Type::Lines;
+                case Geometry::Type::Triangles:
+                case Geometry::Type::TriangleFan:
+                case Geometry::Type::TriangleStrip:
+                    return Geometry::Type::Triangles;
+            }
+
+            return Geometry::Type::Triangles;
+        }
+
+        static void append_indices(
+            Geometry::Type type, const std::vector<unsigned int> &indices, unsigned int base, std::vector<unsigned int> &result
+        )
+        {
+            auto count = indices.size();
+            switch (type) {
+                case Geometry::Type::Points:
+                case Geometry::Type::Lines:
+                case Geometry::Type::Triangles:
+                    for (auto index : indices) {
+                        result.push_back(base + index);
+                    }
+                    break;
+                case Geometry::Type::LineStrip:
+                case Geometry::Type::LineLoop:
+                    for (std::vector<unsigned int>::size_type i = 1; i < count; ++i) {
+                        result.push_back(base + indices[i - 1]);
+                        result.push_back(base + indices[i]);
+                    }
+                    if (type == Geometry::Type::LineLoop && count > 2) {
+                        result.push_back(base + indices[count - 1]);
+                        result.push_back(base + indices[0]);
+                    }
+                    break;
+                case Geometry::Type::TriangleFan:
+                    for (std::vector<unsigned int>::size_type i = 2; i < count; ++i) {
+                        result.push_back(base + indices[0]);
+                        result.push_back(base + indices[i - 1]);
+                        result.push_back(base + indices[i]);
+                    }
+                    break;
+                case Geometry::Type::TriangleStrip:
+                    for (std::vector<unsigned int>::size_type i = 2; i < count; ++i) {
+                        bool odd = (i % 2) != 0;
+                        result.push_back(base + indices[odd ? i - 1 : i - 2]);
+                        result.push_back(base + indices[odd ? i - 2 : i - 1]);
+                        result.push_back(base + indices[i]);
+                    }
+                    break;
+            }
+        }
+
+        [[nodiscard]] const std::vector<std::shared_ptr<Mesh>> &get_meshes() const
+        {
+            return _meshes;
+        }
+
+        [[nodiscard]] const std::shared_ptr<Mesh> &get_mesh() const
+        {
+            return _mesh;
+        }
+
+        [[nodiscard]] bool is_valid() const
+        {
+            auto parent = _parent.lock();
+            for (const auto &mesh : _meshes) {
+                if (!mesh->is_static() || mesh->get_material() != _material || mesh->get_parent().lock() != parent ||
+                    get_batch_type(mesh->get_geometry()->get_type()) != _type) {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+        // A member was moved or recoloured, switched to another geometry or had its geometry modified.
+        [[nodiscard]] bool requires_rebuild() const
+        {
+            for (std::vector<std::shared_ptr<Mesh>>::size_type i = 0; i < _meshes.size(); ++i) {
+                const auto &mesh = _meshes[i];
+                const auto &geometry = mesh->get_geometry();
+                if (mesh->get_model_matrix() != _model_matrices[i] || mesh->get_color() != _colors[i] ||
+                    geometry != _geometries[i] || geometry->get_version() != _geometry_versions[i]) {
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+        // The batch mesh is not one of its parent's children, so it is dirtied here when the parent has moved.
+        void update_world_matrix()
+        {
+            glm::mat4 parent_world_matrix{_get_parent_world_matrix()};
+            if (parent_world_matrix != _parent_world_matrix) {
+                _parent_world_matrix = parent_world_matrix;
+                _mesh->set_world_matrix_requires_update(true);
+            }
+        }
+
+        void rebuild()
+        {
+            std::vector<unsigned int> indices;
+            std::vector<Vertex> vertices;
+            bool frustum_culling_enabled{true};
+
+            _model_matrices.clear();
+            _colors.clear();
+            _geometries.clear();
+            _geometry_versions.clear();
+
+            for (const auto &mesh : _meshes) {
+                const auto &geometry = mesh->get_geometry();
+                const auto &model_matrix = mesh->get_model_matrix();
+                const auto &color = mesh->get_color();
+
+                auto base = static_cast<unsigned int>(vertices.size());
+                append_indices(geometry->get_type(), geometry->get_indices(), base, indices);
+
+                std::vector<Vertex> mesh_vertices{geometry->get_vertices()};
+                Geometry::transform_vertices(mesh_vertices, model_matrix);
+                for (auto &vertex : mesh_vertices) {
+                    vertex.color *= color;
+                }
+                vertices.insert(std::end(vertices), std::begin(mesh_vertices), std::end(mesh_vertices));
+
+                frustum_culling_enabled = frustum_culling_enabled && mesh->is_frustum_culling_enabled();
+
+                _model_matrices.push_back(model_matrix);
+                _colors.push_back(color);
+                _geometries.push_back(geometry);
+                _geometry_versions.push_back(geometry->get_version());
+            }
+
+            const auto &first_geometry = _meshes.front()->get_geometry();
+
+            auto geometry = std::make_shared<ES2Geometry>(indices, vertices);
+            geometry->set_type(_type);
+            geometry->set_line_width(first_geometry->get_line_width());
+
+            const auto &vertex_layout = first_geometry->get_vertex_layout();
+            bool shared_vertex_layout{true};
+            for (const auto &mesh : _meshes) {
+                shared_vertex_layout = shared_vertex_layout && mesh->get_geometry()->get_vertex_layout() == vertex_layout;
+            }
+            if (shared_vertex_layout) {
+                geometry->set_vertex_layout(vertex_layout);
+            }
+
+            _mesh = std::make_shared<Mesh>(
+                geometry, _material, glm::vec3{0.0f}, glm::vec3{0.0f}, glm::vec3{1.0f}, _parent
+            );
+            _mesh->set_name("static batch");
+            _mesh->set_frustum_culling_enabled(frustum_culling_enabled);
+            _parent_world_matrix = _get_parent_world_matrix();
+        }
+
+    private:
+        std::vector<std::shared_ptr<Mesh>> _meshes;
+        std::shared_ptr<Material> _material;
+        std::weak_ptr<Object> _parent;
+        Geometry::Type _type;
+
+        std::shared_ptr<Mesh> _mesh;
+        std::vector<glm::mat4> _model_matrices;
+        std::vector<glm::vec4> _colors;
+        // Held so that a replaced geometry's address cannot be reused by a new one before the batch is rebuilt.
+        std::vector<std::shared_ptr<Geometry>> _geometries;
+        std::vector<size_t> _geometry_versions;
+        glm::mat4 _parent_world_matrix{1.0f};
+
+        [[nodiscard]] glm::mat4 _get_parent_world_matrix() const
+        {
+            auto parent = _parent.lock();
+
+            return parent ? parent->get_world_matrix() : glm::mat4{1.0f};
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,198 @@
+#ifndef FRAME_UNIFORMS_H
+#define FRAME_UNIFORMS_H
+
+#include "scene/scene.h"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <cstddef>
+
+namespace asr
+{
+    class FrameUniforms final
+    {
+    public:
+        struct DirectionalLightData
+        {
+            int enabled{0};
+            int two_sided{0};
+            glm::vec3 view_direction{0.0f};
+            glm::vec3 ambient_color{0.0f};
+            glm::vec3 diffuse_color{0.0f};
+            glm::vec3 specular_color{0.0f};
+            float intensity{0.0f};
+        };
+
+        struct PointLightData
+        {
+            int enabled{0};
+            int two_sided{0};
+            glm::vec3 view_position{0.0f};
+            glm::vec3 ambient_color{0.0f};
+            glm::vec3 diffuse_color{0.0f};
+            glm::vec3 specular_color{0.0f};
+            float intensity{0.0f};
+            float constant_attenuation{0.0f};
+            float linear_attenuation{0.0f};
+            float quadratic_attenuation{0.0f};
+        };
+
+        struct SpotLightData
+        {
+            int enabled{0};
+            int two_sided{0};
+            glm::vec3 view_position{0.0f};
+            glm::vec3 view_direction{0.0f};
+            glm::vec3 ambient_color{0.0f};
+            glm::vec3 diffuse_color{0.0f};
+            glm::vec3 specular_color{0.0f};
+            float exponent{0.0f};
+            float cutoff_angle_cosine{0.0f};
+            float intensity{0.0f};
+            float constant_attenuation{0.0f};
+            float linear_attenuation{0.0f};
+            float quadratic_attenuation{0.0f};
+        };
+
+        /* Per-draw values the renderer computes ahead of submission, possibly on worker threads. */
+        struct DrawData
+        {
+            glm::mat4 model_view_matrix{1.0f};
+            glm::mat3 normal_matrix{1.0f};
+        };
+
+        [[nodiscard]] size_t get_frame() const
+        {
+            return _frame;
+        }
+
+        [[nodiscard]] const glm::mat4 &get_view_matrix() const
+        {
+            return _view_matrix;
+        }
+
+        [[nodiscard]] const glm::mat4 &get_projection_matrix() const
+        {
+            return _projection_matrix;
+        }
+
+        [[nodiscard]] const glm::mat4 &get_orthographic_projection_matrix() const
+        {
+            return _orthographic_projection_matrix;
+        }
+
+        [[nodiscard]] const glm::vec3 &get_ambient_light_color() const
+        {
+            return _ambient_light_color;
+        }
+
+        [[nodiscard]] const std::vector<DirectionalLightData> &get_directional_lights() const
+        {
+            return _directional_lights;
+        }
+
+        [[nodiscard]] const std::vector<PointLightData> &get_point_lights() const
+        {
+            return _point_lights;
+        }
+
+        [[nodiscard]] const std::vector<SpotLightData> &get_spot_lights() const
+        {
+            return _spot_lights;
+        }
+
+        [[nodiscard]] const DrawData *get_draw_data() const
+        {
+            return _draw_data;
+        }
+
+        void set_draw_data(const DrawData *draw_data)
+        {
+            _draw_data = draw_data;
+        }
+
+        void update(const Scene &scene)
+        {
+            ++_frame;
+
+            const auto &camera = scene.get_camera();
+            _view_matrix = camera->get_view_matrix();
+            _projection_matrix = camera->get_projection_matrix();
+            _orthographic_projection_matrix = camera->get_orthographic_projection_matrix();
+
+            _ambient_light_color = scene.get_ambient_light()->get_ambient_color();
+
+            const auto &directional_lights = scene.get_directional_lights();
+            _directional_lights.resize(directional_lights.size());
+            for (std::vector<DirectionalLightData>::size_type i = 0; i < directional_lights.size(); ++i) {
+                const auto &directional_light = directional_lights[i];
+                auto &data = _directional_lights[i];
+
+                data.enabled = static_cast<int>(directional_light->is_enabled());
+                data.two_sided = static_cast<int>(directional_light->is_two_sided());
+                data.view_direction = glm::vec3(_view_matrix * glm::vec4(directional_light->get_world_direction(), 0.0f));
+                data.ambient_color = directional_light->get_ambient_color();
+                data.diffuse_color = directional_light->get_diffuse_color();
+                data.specular_color = directional_light->get_specular_color();
+                data.intensity = directional_light->get_intensity();
+            }
+
+            const auto &point_lights = scene.get_point_lights();
+            _point_lights.resize(point_lights.size());
+            for (std::vector<PointLightData>::size_type i = 0; i < point_lights.size(); ++i) {
+                const auto &point_light = point_lights[i];
+                auto &data = _point_lights[i];
+
+                data.enabled = static_cast<int>(point_light->is_enabled());
+                data.two_sided = static_cast<int>(point_light->is_two_sided());
+                data.view_position = glm::vec3(_view_matrix * point_light->get_world_matrix() * glm::vec4(point_light->get_position(), 1.0f));
+                data.ambient_color = point_light->get_ambient_color();
+                data.diffuse_color = point_light->get_diffuse_color();
+                data.specular_color = point_light->get_specular_color();
+                data.intensity = point_light->get_intensity();
+                data.constant_attenuation = point_light->get_constant_attenuation();
+                data.linear_attenuation = point_light->get_linear_attenuation();
+                data.quadratic_attenuation = point_light->get_quadratic_attenuation();
+            }
+
+            const auto &spot_lights = scene.get_spot_lights();
+            _spot_lights.resize(spot_lights.size());
+            for (std::vector<SpotLightData>::size_type i = 0; i < spot_lights.size(); ++i) {
+                const auto &spot_light = spot_lights[i];
+                auto &data = _spot_lights[i];
+
+                data.enabled = static_cast<int>(spot_light->is_enabled());
+                data.two_sided = static_cast<int>(spot_light->is_two_sided());
+                data.view_position = glm::vec3(_view_matrix * spot_light->get_world_matrix() * glm::vec4(spot_light->get_position(), 1.0f));
+                data.view_direction = glm::vec3(_view_matrix * glm::vec4(spot_light->get_world_direction(), 0.0f));
+                data.ambient_color = spot_light->get_ambient_color();
+                data.diffuse_color = spot_light->get_diffuse_color();
+                data.specular_color = spot_light->get_specular_color();
+                data.exponent = spot_light->get_exponent();
+                data.cutoff_angle_cosine = spot_light->get_cutoff_angle();
+                data.intensity = spot_light->get_intensity();
+                data.constant_attenuation = spot_light->get_constant_attenuation();
+                data.linear_attenuation = spot_light->get_linear_attenuation();
+                data.quadratic_attenuation = spot_light->get_quadratic_attenuation();
+            }
+        }
+
+    private:
+        size_t _frame{0};
+
+        glm::mat4 _view_matrix{1.0f};
+        glm::mat4 _projection_matrix{1.0f};
+        glm::mat4 _orthographic_projection_matrix{1.0f};
+
+        glm::vec3 _ambient_light_color{0.0f};
+
+        std::vector<DirectionalLightData> _directional_lights;
+        std::vector<PointLightData> _point_lights;
+        std::vector<SpotLightData> _spot_lights;
+
+        const DrawData *_draw_data{nullptr};
+    };
+}
+
+#endif
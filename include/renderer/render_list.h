@@ -0,0 +1,171 @@
+#ifndef RENDER_LIST_H
+#define RENDER_LIST_H
+
+#include "objects/object.h"
+#include "objects/mesh.h"
+#include "materials/material.h"
+#include "scene/bvh.h"
+
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include <algorithm>
+
+namespace asr
+{
+    class RenderList final : public Object::Listener,
+                             public Material::Listener,
+                             public std::enable_shared_from_this<RenderList>
+    {
+    public:
+        [[nodiscard]] const std::shared_ptr<BVH> &get_bvh() const
+        {
+            return _bvh;
+        }
+
+        [[nodiscard]] size_t get_version() const
+        {
+            return _version;
+        }
+
+        const std::vector<std::shared_ptr<Mesh>> &get_meshes()
+        {
+            _update_passes_if_necessary();
+
+            return _meshes;
+        }
+
+        [[nodiscard]] size_t get_mesh_index(const Mesh &mesh) const
+        {
+            return _mesh_indices.at(&mesh);
+        }
+
+        std::vector<std::shared_ptr<Mesh>> &get_opaque_meshes()
+        {
+            _update_passes_if_necessary();
+
+            return _opaque_meshes;
+        }
+
+        std::vector<std::shared_ptr<Mesh>> &get_transparent_meshes()
+        {
+            _update_passes_if_necessary();
+
+            return _transparent_meshes;
+        }
+
+        std::vector<std::shared_ptr<Mesh>> &get_overlay_meshes()
+        {
+            _update_passes_if_necessary();
+
+            return _overlay_meshes;
+        }
+
+        void on_object_added(const std::shared_ptr<Object> &object) final
+        {
+            auto mesh = std::dynamic_pointer_cast<Mesh>(object);
+            if (!mesh || _mesh_indices.count(mesh.get()) > 0) {
+                return;
+            }
+
+            _mesh_indices[mesh.get()] = _meshes.size();
+            _meshes.push_back(mesh);
+            _bvh->insert(mesh);
+            ++_version;
+
+            const auto &material = mesh->get_material();
+            if (_material_references[material.get()]++ == 0) {
+                material->add_listener(shared_from_this());
+            }
+
+            if (!_passes_require_update) {
+                _add_to_pass(mesh);
+            }
+        }
+
+        void on_object_removed(const std::shared_ptr<Object> &object) final
+        {
+            auto mesh = std::dynamic_pointer_cast<Mesh>(object);
+            if (!mesh) {
+                return;
+            }
+
+            auto mesh_index = _mesh_indices.find(mesh.get());
+            if (mesh_index == _mesh_indices.end()) {
+                return;
+            }
+
+            _meshes[mesh_index->second] = nullptr;
+            _mesh_indices.erase(mesh_index);
+            _bvh->remove(mesh);
+            ++_version;
+
+            const auto &material = mesh->get_material();
+            if (--_material_references[material.get()] == 0) {
+                _material_references.erase(material.get());
+                material->remove_listener(shared_from_this());
+            }
+
+            _passes_require_update = true;
+        }
+
+        void on_object_changed(const std::shared_ptr<Object> &object) final
+        {
+            if (std::dynamic_pointer_cast<Mesh>(object)) {
+                ++_version;
+            }
+        }
+
+        void on_material_changed(Material &) final
+        {
+            _passes_require_update = true;
+            ++_version;
+        }
+
+    private:
+        std::vector<std::shared_ptr<Mesh>> _meshes;
+        std::unordered_map<const Mesh *, std::vector<std::shared_ptr<Mesh>>::size_type> _mesh_indices;
+        std::unordered_map<const Material *, size_t> _material_references;
+        std::shared_ptr<BVH> _bvh{std::make_shared<BVH>()};
+        size_t _version{0};
+
+        bool _passes_require_update{false};
+        std::vector<std::shared_ptr<Mesh>> _opaque_meshes;
+        std::vector<std::shared_ptr<Mesh>> _transparent_meshes;
+        std::vector<std::shared_ptr<Mesh>> _overlay_meshes;
+
+        void _add_to_pass(const std::shared_ptr<Mesh> &mesh)
+        {
+            const auto &material = mesh->get_material();
+            if (material->is_overlay()) {
+                _overlay_meshes.push_back(mesh);
+            } else if (material->is_transparent()) {
+                _transparent_meshes.push_back(mesh);
+            } else {
+                _opaque_meshes.push_back(mesh);
+            }
+        }
+
+        void _update_passes_if_necessary()
+        {
+            if (_passes_require_update) {
+                _meshes.erase(std::remove(std::begin(_meshes), std::end(_meshes), nullptr), std::end(_meshes));
+                for (std::vector<std::shared_ptr<Mesh>>::size_type i = 0; i < _meshes.size(); ++i) {
+                    _mesh_indices[_meshes[i].get()] = i;
+                }
+
+                _opaque_meshes.clear();
+                _transparent_meshes.clear();
+                _overlay_meshes.clear();
+
+                for (const auto &mesh : _meshes) {
+                    _add_to_pass(mesh);
+                }
+
+                _passes_require_update = false;
+            }
+        }
+    };
+}
+
+#endif
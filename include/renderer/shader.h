@@ -1,16 +1,31 @@
 #ifndef SHADER_H
 #define SHADER_H
 
+#include <glm/glm.hpp>
+
 #include <string>
 #include <vector>
+#include <array>
 #include <utility>
 #include <map>
+#include <cstring>
+#include <cstddef>
 
 namespace asr
 {
     class Shader
     {
     public:
+        struct Attribute
+        {
+            int slot{-1};
+        };
+
+        struct Uniform
+        {
+            int slot{-1};
+        };
+
         Shader(
             std::string vertex_shader_source,
             std::string fragment_shader_source,
@@ -20,10 +35,10 @@ namespace asr
             _fragment_shader_source{std::move(fragment_shader_source)}
         {
             for (const auto &uniform : uniforms) {
-                _uniforms[uniform] = -1;
+                add_uniform(uniform);
             }
             for (const auto &attribute : attributes) {
-                _attributes[attribute] = -1;
+                add_attribute(attribute);
             }
         }
 
@@ -49,26 +64,114 @@ namespace asr
             _fragment_shader_source = fragment_shader_source;
         }
 
-        std::map<std::string, int> &get_attributes()
+        Attribute add_attribute(const std::string &name)
+        {
+            auto attribute_slot = _attribute_slots.find(name);
+            if (attribute_slot != _attribute_slots.end()) {
+                return Attribute{attribute_slot->second};
+            }
+
+            int slot{static_cast<int>(_attribute_names.size())};
+            _attribute_slots[name] = slot;
+            _attribute_names.push_back(name);
+            _attribute_locations.push_back(_program != -1 ? _find_attribute_location(name) : -1);
+
+            return Attribute{slot};
+        }
+
+        [[nodiscard]] Attribute get_attribute(const std::string &name) const
+        {
+            auto attribute_slot = _attribute_slots.find(name);
+
+            return Attribute{attribute_slot != _attribute_slots.end() ? attribute_slot->second : -1};
+        }
+
+        [[nodiscard]] int get_attribute_location(Attribute attribute) const
+        {
+            return attribute.slot != -1 ? _attribute_locations[static_cast<size_t>(attribute.slot)] : -1;
+        }
+
+        [[nodiscard]] const std::vector<std::string> &get_attribute_names() const
+        {
+            return _attribute_names;
+        }
+
+        Uniform add_uniform(const std::string &name)
+        {
+            auto uniform_slot = _uniform_slots.find(name);
+            if (uniform_slot != _uniform_slots.end()) {
+                return Uniform{uniform_slot->second};
+            }
+
+            int slot{static_cast<int>(_uniform_names.size())};
+            _uniform_slots[name] = slot;
+            _uniform_names.push_back(name);
+            _uniform_locations.push_back(_program != -1 ? _find_uniform_location(name) : -1);
+            _uniform_values.emplace_back();
+
+            return Uniform{slot};
+        }
+
+        [[nodiscard]] Uniform get_uniform(const std::string &name) const
         {
-            return _attributes;
+            auto uniform_slot = _uniform_slots.find(name);
+
+            return Uniform{uniform_slot != _uniform_slots.end() ? uniform_slot->second : -1};
         }
 
-        [[nodiscard]] const std::map<std::string, int> &get_attributes() const
+        [[nodiscard]] int get_uniform_location(Uniform uniform) const
         {
-            return _attributes;
+            return uniform.slot != -1 ? _uniform_locations[static_cast<size_t>(uniform.slot)] : -1;
         }
 
-        std::map<std::string, int> &get_uniforms()
+        [[nodiscard]] const std::vector<std::string> &get_uniform_names() const
         {
-            return _uniforms;
+            return _uniform_names;
         }
 
-        [[nodiscard]] const std::map<std::string, int> &get_uniforms() const
+        [[nodiscard]] size_t get_uniform_upload_count() const
         {
-            return _uniforms;
+            return _uniform_upload_count;
         }
 
+        [[nodiscard]] size_t get_skipped_uniform_upload_count() const
+        {
+            return _skipped_uniform_upload_count;
+        }
+
+        void reset_uniform_upload_counters()
+        {
+            _uniform_upload_count = 0;
+            _skipped_uniform_upload_count = 0;
+        }
+
+        [[nodiscard]] size_t get_frame_uniforms_frame() const
+        {
+            return _frame_uniforms_frame;
+        }
+
+        void set_frame_uniforms_frame(size_t frame_uniforms_frame)
+        {
+            _frame_uniforms_frame = frame_uniforms_frame;
+        }
+
+        virtual void set_uniform(Uniform uniform, int value) = 0;
+
+        virtual void set_uniform(Uniform uniform, float value) = 0;
+
+        virtual void set_uniform(Uniform uniform, const glm::vec3 &value) = 0;
+
+        virtual void set_uniform(Uniform uniform, const glm::vec4 &value) = 0;
+
+        virtual void set_uniform(Uniform uniform, const glm::mat3 &value) = 0;
+
+        virtual void set_uniform(Uniform uniform, const glm::mat4 &value) = 0;
+
+        // Uploads count elements of a uniform array starting at its first element. Arrays are not cached.
+        virtual void set_uniform(Uniform uniform, const glm::vec4 *values, size_t count) = 0;
+
+        virtual void set_uniform(Uniform uniform, const glm::mat4 *values, size_t count) = 0;
+
         [[nodiscard]] bool is_dead() const
         {
             return _dead;
@@ -79,6 +182,11 @@ namespace asr
             return _program != -1;
         }
 
+        [[nodiscard]] bool is_compiling() const
+        {
+            return _compiling;
+        }
+
         virtual void compile() = 0;
 
         virtual void cleanup() = 0;
@@ -89,11 +197,71 @@ namespace asr
         std::string _vertex_shader_source;
         std::string _fragment_shader_source;
 
-        std::map<std::string, int> _attributes;
-        std::map<std::string, int> _uniforms;
+        std::map<std::string, int> _attribute_slots;
+        std::vector<std::string> _attribute_names;
+        std::vector<int> _attribute_locations;
+
+        std::map<std::string, int> _uniform_slots;
+        std::vector<std::string> _uniform_names;
+        std::vector<int> _uniform_locations;
+
+        struct UniformValue
+        {
+            std::array<float, 16> components{};
+            size_t size{0};
+        };
+
+        std::vector<UniformValue> _uniform_values;
+        size_t _uniform_upload_count{0};
+        size_t _skipped_uniform_upload_count{0};
+        size_t _frame_uniforms_frame{0};
 
         bool _dead{false};
+        bool _compiling{false};
         int _program{-1};
+
+        [[nodiscard]] virtual int _find_attribute_location(const std::string &name) const = 0;
+
+        [[nodiscard]] virtual int _find_uniform_location(const std::string &name) const = 0;
+
+        bool _uniform_value_requires_upload(Uniform uniform, const void *value, size_t size)
+        {
+            if (uniform.slot == -1 || _uniform_locations[static_cast<size_t>(uniform.slot)] == -1) {
+                return false;
+            }
+
+            auto &uniform_value = _uniform_values[static_cast<size_t>(uniform.slot)];
+            if (uniform_value.size == size && std::memcmp(uniform_value.components.data(), value, size) == 0) {
+                ++_skipped_uniform_upload_count;
+                return false;
+            }
+
+            std::memcpy(uniform_value.components.data(), value, size);
+            uniform_value.size = size;
+            ++_uniform_upload_count;
+
+            return true;
+        }
+
+        bool _uniform_array_requires_upload(Uniform uniform, size_t count)
+        {
+            if (uniform.slot == -1 || _uniform_locations[static_cast<size_t>(uniform.slot)] == -1 || count == 0) {
+                return false;
+            }
+
+            _uniform_values[static_cast<size_t>(uniform.slot)].size = 0;
+            ++_uniform_upload_count;
+
+            return true;
+        }
+
+        void _forget_uniform_values()
+        {
+            for (auto &uniform_value : _uniform_values) {
+                uniform_value.size = 0;
+            }
+            _frame_uniforms_frame = 0;
+        }
     };
 }
 
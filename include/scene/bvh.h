@@ -0,0 +1,636 @@
+#ifndef BVH_H
+#define BVH_H
+
+#include "objects/mesh.h"
+#include "math/aabb.h"
+#include "math/sphere.h"
+#include "math/frustum.h"
+#include "math/ray.h"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include <algorithm>
+#include <utility>
+#include <cmath>
+
+namespace asr
+{
+    class BVH final : public Mesh::BoundsListener,
+                      public Geometry::BoundsListener,
+                      public std::enable_shared_from_this<BVH>
+    {
+    public:
+        [[nodiscard]] float get_margin_ratio() const
+        {
+            return _margin_ratio;
+        }
+
+        void set_margin_ratio(float margin_ratio)
+        {
+            _margin_ratio = margin_ratio;
+        }
+
+        [[nodiscard]] size_t get_mesh_count() const
+        {
+            return _leaves.size();
+        }
+
+        [[nodiscard]] int get_height() const
+        {
+            return _root != _Null ? _nodes[static_cast<size_t>(_root)].height : 0;
+        }
+
+        void insert(const std::shared_ptr<Mesh> &mesh)
+        {
+            if (_leaves.count(mesh.get()) > 0) {
+                return;
+            }
+
+            int leaf = _allocate_node();
+            auto &node = _nodes[static_cast<size_t>(leaf)];
+            node.mesh = mesh;
+            _leaves[mesh.get()] = leaf;
+
+            mesh->set_bounds_listener(shared_from_this());
+            _register_geometry(leaf);
+
+            _place_leaf(leaf);
+        }
+
+        void remove(const std::shared_ptr<Mesh> &mesh)
+        {
+            auto entry = _leaves.find(mesh.get());
+            if (entry == _leaves.end()) {
+                return;
+            }
+
+            int leaf = entry->second;
+            _leaves.erase(entry);
+
+            auto &node = _nodes[static_cast<size_t>(leaf)];
+            if (node.unbounded) {
+                _remove_unbounded_leaf(leaf);
+            } else {
+                _remove_leaf(leaf);
+            }
+            if (node.moved) {
+                _moved_leaves.erase(std::remove(std::begin(_moved_leaves), std::end(_moved_leaves), leaf), std::end(_moved_leaves));
+            }
+
+            if (mesh->get_bounds_listener().get() == this) {
+                mesh->set_bounds_listener(nullptr);
+            }
+            _unregister_geometry(leaf);
+
+            _free_node(leaf);
+        }
+
+        void update_mesh(const Mesh &mesh)
+        {
+            auto entry = _leaves.find(&mesh);
+            if (entry == _leaves.end()) {
+                return;
+            }
+
+            _mark_leaf_moved(entry->second);
+        }
+
+        void update()
+        {
+            for (int leaf : _moved_leaves) {
+                auto &node = _nodes[static_cast<size_t>(leaf)];
+                node.moved = false;
+                if (node.geometry != node.mesh->get_geometry()) {
+                    _unregister_geometry(leaf);
+                    _register_geometry(leaf);
+                }
+
+                bool unbounded = !node.mesh->is_frustum_culling_enabled();
+                if (unbounded != node.unbounded) {
+                    if (node.unbounded) {
+                        _remove_unbounded_leaf(leaf);
+                    } else {
+                        _remove_leaf(leaf);
+                    }
+                    _place_leaf(leaf);
+                    continue;
+                }
+                if (unbounded) {
+                    continue;
+                }
+
+                const auto &bounding_box = node.mesh->get_world_bounding_box();
+                if (_contains(node.minimum, node.maximum, bounding_box.get_minimum(), bounding_box.get_maximum())) {
+                    continue;
+                }
+
+                _remove_leaf(leaf);
+                _place_leaf(leaf);
+            }
+            _moved_leaves.clear();
+        }
+
+        void on_mesh_bounds_changed(Mesh &mesh) final
+        {
+            update_mesh(mesh);
+        }
+
+        // Vertices edited in place move every leaf sharing the geometry, without touching the other leaves.
+        void on_geometry_bounds_changed(Geometry &geometry) final
+        {
+            auto entry = _geometry_leaves.find(&geometry);
+            if (entry == _geometry_leaves.end()) {
+                return;
+            }
+
+            for (int leaf : entry->second) {
+                _mark_leaf_moved(leaf);
+            }
+        }
+
+        void query_frustum(const Frustum &frustum, std::vector<std::shared_ptr<Mesh>> &meshes) const
+        {
+            for (int leaf : _unbounded_leaves) {
+                meshes.push_back(_nodes[static_cast<size_t>(leaf)].mesh);
+            }
+
+            _query(
+                [&](const Node &node) { return frustum.intersects_box(_get_box(node)); },
+                [&](const Node &node) { return frustum.contains_box(_get_box(node)); },
+                [&](const std::shared_ptr<Mesh> &mesh) {
+                    return frustum.intersects_sphere(mesh->get_world_bounding_sphere()) &&
+                           frustum.intersects_box(mesh->get_world_bounding_box());
+                },
+                meshes
+            );
+        }
+
+        void query_sphere(const Sphere &sphere, std::vector<std::shared_ptr<Mesh>> &meshes) const
+        {
+            auto intersects = [&](const glm::vec3 &minimum, const glm::vec3 &maximum) {
+                glm::vec3 closest_point = glm::min(glm::max(sphere.get_center(), minimum), maximum);
+                glm::vec3 offset = closest_point - sphere.get_center();
+
+                return glm::dot(offset, offset) <= sphere.get_radius() * sphere.get_radius();
+            };
+
+            _query(
+                [&](const Node &node) { return intersects(node.minimum, node.maximum); },
+                [](const Node &) { return false; },
+                [&](const std::shared_ptr<Mesh> &mesh) {
+                    const auto &bounding_box = mesh->get_world_bounding_box();
+                    return intersects(bounding_box.get_minimum(), bounding_box.get_maximum());
+                },
+                meshes
+            );
+        }
+
+        void query_box(const AABB &box, std::vector<std::shared_ptr<Mesh>> &meshes) const
+        {
+            auto intersects = [&](const glm::vec3 &minimum, const glm::vec3 &maximum) {
+                return _overlaps(minimum, maximum, box.get_minimum(), box.get_maximum());
+            };
+
+            _query(
+                [&](const Node &node) { return intersects(node.minimum, node.maximum); },
+                [&](const Node &node) { return _contains(box.get_minimum(), box.get_maximum(), node.minimum, node.maximum); },
+                [&](const std::shared_ptr<Mesh> &mesh) {
+                    const auto &bounding_box = mesh->get_world_bounding_box();
+                    return intersects(bounding_box.get_minimum(), bounding_box.get_maximum());
+                },
+                meshes
+            );
+        }
+
+        void query_ray(const Ray &ray, std::vector<std::shared_ptr<Mesh>> &meshes) const
+        {
+            std::vector<std::pair<float, std::shared_ptr<Mesh>>> hits;
+
+            std::vector<int> stack;
+            if (_root != _Null) {
+                stack.push_back(_root);
+            }
+            while (!stack.empty()) {
+                const auto &node = _nodes[static_cast<size_t>(stack.back())];
+                stack.pop_back();
+
+                if (!ray.intersects_with_box(_get_box(node)).first) {
+                    continue;
+                }
+
+                if (node.is_leaf()) {
+                    auto [intersects, distance] = ray.intersects_with_box(node.mesh->get_world_bounding_box());
+                    if (intersects) {
+                        hits.emplace_back(distance, node.mesh);
+                    }
+                } else {
+                    stack.push_back(node.left);
+                    stack.push_back(node.right);
+                }
+            }
+
+            std::sort(std::begin(hits), std::end(hits), [](const auto &a, const auto &b) {
+                return a.first < b.first;
+            });
+            for (const auto &hit : hits) {
+                meshes.push_back(hit.second);
+            }
+        }
+
+    private:
+        static constexpr int _Null{-1};
+
+        struct Node
+        {
+            glm::vec3 minimum{0.0f};
+            glm::vec3 maximum{0.0f};
+
+            int parent{_Null};
+            int left{_Null};
+            int right{_Null};
+            int height{0};
+
+            std::shared_ptr<Mesh> mesh;
+            std::shared_ptr<Geometry> geometry;
+            bool moved{false};
+            bool unbounded{false};
+
+            [[nodiscard]] bool is_leaf() const
+            {
+                return left == _Null;
+            }
+        };
+
+        std::vector<Node> _nodes;
+        int _root{_Null};
+        int _free_list{_Null};
+
+        std::unordered_map<const Mesh *, int> _leaves;
+        std::unordered_map<const Geometry *, std::vector<int>> _geometry_leaves;
+        std::vector<int> _moved_leaves;
+        std::vector<int> _unbounded_leaves;
+
+        float _margin_ratio{0.1f};
+
+        static AABB _get_box(const Node &node)
+        {
+            return AABB{node.minimum, node.maximum};
+        }
+
+        static bool _contains(const glm::vec3 &outer_minimum, const glm::vec3 &outer_maximum,
+                              const glm::vec3 &inner_minimum, const glm::vec3 &inner_maximum)
+        {
+            return outer_minimum.x <= inner_minimum.x && outer_minimum.y <= inner_minimum.y && outer_minimum.z <= inner_minimum.z &&
+                   inner_maximum.x <= outer_maximum.x && inner_maximum.y <= outer_maximum.y && inner_maximum.z <= outer_maximum.z;
+        }
+
+        static bool _overlaps(const glm::vec3 &a_minimum, const glm::vec3 &a_maximum,
+                              const glm::vec3 &b_minimum, const glm::vec3 &b_maximum)
+        {
+            return a_minimum.x <= b_maximum.x && a_minimum.y <= b_maximum.y && a_minimum.z <= b_maximum.z &&
+                   b_minimum.x <= a_maximum.x && b_minimum.y <= a_maximum.y && b_minimum.z <= a_maximum.z;
+        }
+
+        static float _get_area(const glm::vec3 &minimum, const glm::vec3 &maximum)
+        {
+            glm::vec3 size = maximum - minimum;
+
+            return size.x * size.y + size.y * size.z + size.z * size.x;
+        }
+
+        template <typename IntersectsNode, typename ContainsNode, typename IntersectsMesh>
+        void _query(IntersectsNode intersects_node, ContainsNode contains_node, IntersectsMesh intersects_mesh,
+                    std::vector<std::shared_ptr<Mesh>> &meshes) const
+        {
+            std::vector<int> stack;
+            if (_root != _Null) {
+                stack.push_back(_root);
+            }
+            while (!stack.empty()) {
+                const auto &node = _nodes[static_cast<size_t>(stack.back())];
+                stack.pop_back();
+
+                if (!intersects_node(node)) {
+                    continue;
+                }
+
+                if (node.is_leaf()) {
+                    if (intersects_mesh(node.mesh)) {
+                        meshes.push_back(node.mesh);
+                    }
+                } else if (contains_node(node)) {
+                    _collect_leaves(node, meshes);
+                } else {
+                    stack.push_back(node.right);
+                    stack.push_back(node.left);
+                }
+            }
+        }
+
+        void _collect_leaves(const Node &subtree, std::vector<std::shared_ptr<Mesh>> &meshes) const
+        {
+            std::vector<const Node *> stack{&subtree};
+            while (!stack.empty()) {
+                const auto *node = stack.back();
+                stack.pop_back();
+
+                if (node->is_leaf()) {
+                    meshes.push_back(node->mesh);
+                } else {
+                    stack.push_back(&_nodes[static_cast<size_t>(node->right)]);
+                    stack.push_back(&_nodes[static_cast<size_t>(node->left)]);
+                }
+            }
+        }
+
+        int _allocate_node()
+        {
+            if (_free_list == _Null) {
+                _nodes.emplace_back();
+                return static_cast<int>(_nodes.size() - 1);
+            }
+
+            int index = _free_list;
+            _free_list = _nodes[static_cast<size_t>(index)].parent;
+            _nodes[static_cast<size_t>(index)] = Node{};
+
+            return index;
+        }
+
+        void _free_node(int index)
+        {
+            auto &node = _nodes[static_cast<size_t>(index)];
+            node = Node{};
+            node.parent = _free_list;
+            _free_list = index;
+        }
+
+        void _mark_leaf_moved(int leaf)
+        {
+            auto &node = _nodes[static_cast<size_t>(leaf)];
+            if (!node.moved) {
+                node.moved = true;
+                _moved_leaves.push_back(leaf);
+            }
+        }
+
+        // Leaves are indexed by the geometry their mesh uses, which is listened to while any leaf refers to it.
+        void _register_geometry(int leaf)
+        {
+            auto &node = _nodes[static_cast<size_t>(leaf)];
+            node.geometry = node.mesh->get_geometry();
+            if (!node.geometry) {
+                return;
+            }
+
+            auto &leaves = _geometry_leaves[node.geometry.get()];
+            if (leaves.empty()) {
+                node.geometry->add_bounds_listener(shared_from_this());
+            }
+            leaves.push_back(leaf);
+        }
+
+        void _unregister_geometry(int leaf)
+        {
+            auto &node = _nodes[static_cast<size_t>(leaf)];
+            if (!node.geometry) {
+                return;
+            }
+
+            auto entry = _geometry_leaves.find(node.geometry.get());
+            auto &leaves = entry->second;
+            leaves.erase(std::remove(std::begin(leaves), std::end(leaves), leaf), std::end(leaves));
+            if (leaves.empty()) {
+                _geometry_leaves.erase(entry);
+                node.geometry->remove_bounds_listener(this);
+            }
+            node.geometry = nullptr;
+        }
+
+        void _place_leaf(int leaf)
+        {
+            auto &node = _nodes[static_cast<size_t>(leaf)];
+            node.unbounded = !node.mesh->is_frustum_culling_enabled();
+            if (node.unbounded) {
+                _unbounded_leaves.push_back(leaf);
+                return;
+            }
+
+            const auto &bounding_box = node.mesh->get_world_bounding_box();
+            glm::vec3 margin{(bounding_box.get_maximum() - bounding_box.get_minimum()) * _margin_ratio};
+            node.minimum = bounding_box.get_minimum() - margin;
+            node.maximum = bounding_box.get_maximum() + margin;
+
+            _insert_leaf(leaf);
+        }
+
+        void _remove_unbounded_leaf(int leaf)
+        {
+            _unbounded_leaves.erase(
+                std::remove(std::begin(_unbounded_leaves), std::end(_unbounded_leaves), leaf),
+                std::end(_unbounded_leaves)
+            );
+            _nodes[static_cast<size_t>(leaf)].unbounded = false;
+        }
+
+        void _insert_leaf(int leaf)
+        {
+            if (_root == _Null) {
+                _root = leaf;
+                _nodes[static_cast<size_t>(leaf)].parent = _Null;
+                return;
+            }
+
+            glm::vec3 leaf_minimum = _nodes[static_cast<size_t>(leaf)].minimum;
+            glm::vec3 leaf_maximum = _nodes[static_cast<size_t>(leaf)].maximum;
+
+            int index = _root;
+            while (!_nodes[static_cast<size_t>(index)].is_leaf()) {
+                const auto &node = _nodes[static_cast<size_t>(index)];
+
+                float area = _get_area(node.minimum, node.maximum);
+                float combined_area = _get_area(glm::min(node.minimum, leaf_minimum), glm::max(node.maximum, leaf_maximum));
+
+                float cost = 2.0f * combined_area;
+                float inheritance_cost = 2.0f * (combined_area - area);
+
+                auto child_cost = [&](int child_index) {
+                    const auto &child = _nodes[static_cast<size_t>(child_index)];
+                    float child_combined_area =
+                        _get_area(glm::min(child.minimum, leaf_minimum), glm::max(child.maximum, leaf_maximum));
+                    if (child.is_leaf()) {
+                        return child_combined_area + inheritance_cost;
+                    }
+
+                    return child_combined_area - _get_area(child.minimum, child.maximum) + inheritance_cost;
+                };
+
+                float left_cost = child_cost(node.left);
+                float right_cost = child_cost(node.right);
+                if (cost < left_cost && cost < right_cost) {
+                    break;
+                }
+
+                index = left_cost < right_cost ? node.left : node.right;
+            }
+
+            int sibling = index;
+            int old_parent = _nodes[static_cast<size_t>(sibling)].parent;
+            int new_parent = _allocate_node();
+
+            auto &parent_node = _nodes[static_cast<size_t>(new_parent)];
+            auto &sibling_node = _nodes[static_cast<size_t>(sibling)];
+            auto &leaf_node = _nodes[static_cast<size_t>(leaf)];
+
+            parent_node.parent = old_parent;
+            parent_node.minimum = glm::min(sibling_node.minimum, leaf_minimum);
+            parent_node.maximum = glm::max(sibling_node.maximum, leaf_maximum);
+            parent_node.height = sibling_node.height + 1;
+            parent_node.left = sibling;
+            parent_node.right = leaf;
+            sibling_node.parent = new_parent;
+            leaf_node.parent = new_parent;
+
+            if (old_parent != _Null) {
+                auto &old_parent_node = _nodes[static_cast<size_t>(old_parent)];
+                if (old_parent_node.left == sibling) {
+                    old_parent_node.left = new_parent;
+                } else {
+                    old_parent_node.right = new_parent;
+                }
+            } else {
+                _root = new_parent;
+            }
+
+            _refit_ancestors(new_parent);
+        }
+
+        void _remove_leaf(int leaf)
+        {
+            if (leaf == _root) {
+                _root = _Null;
+                return;
+            }
+
+            int parent = _nodes[static_cast<size_t>(leaf)].parent;
+            const auto &parent_node = _nodes[static_cast<size_t>(parent)];
+            int grand_parent = parent_node.parent;
+            int sibling = parent_node.left == leaf ? parent_node.right : parent_node.left;
+
+            if (grand_parent != _Null) {
+                auto &grand_parent_node = _nodes[static_cast<size_t>(grand_parent)];
+                if (grand_parent_node.left == parent) {
+                    grand_parent_node.left = sibling;
+                } else {
+                    grand_parent_node.right = sibling;
+                }
+                _nodes[static_cast<size_t>(sibling)].parent = grand_parent;
+                _free_node(parent);
+
+                _refit_ancestors(grand_parent);
+            } else {
+                _root = sibling;
+                _nodes[static_cast<size_t>(sibling)].parent = _Null;
+                _free_node(parent);
+            }
+
+            _nodes[static_cast<size_t>(leaf)].parent = _Null;
+        }
+
+        void _refit_ancestors(int index)
+        {
+            while (index != _Null) {
+                index = _balance(index);
+
+                auto &node = _nodes[static_cast<size_t>(index)];
+                const auto &left = _nodes[static_cast<size_t>(node.left)];
+                const auto &right = _nodes[static_cast<size_t>(node.right)];
+
+                node.height = 1 + std::max(left.height, right.height);
+                node.minimum = glm::min(left.minimum, right.minimum);
+                node.maximum = glm::max(left.maximum, right.maximum);
+
+                index = node.parent;
+            }
+        }
+
+        int _balance(int a)
+        {
+            auto &node_a = _nodes[static_cast<size_t>(a)];
+            if (node_a.is_leaf() || node_a.height < 2) {
+                return a;
+            }
+
+            int b = node_a.left;
+            int c = node_a.right;
+            auto &node_b = _nodes[static_cast<size_t>(b)];
+            auto &node_c = _nodes[static_cast<size_t>(c)];
+
+            int balance = node_c.height - node_b.height;
+            if (balance > 1) {
+                return _rotate_up(a, c, false);
+            }
+            if (balance < -1) {
+                return _rotate_up(a, b, true);
+            }
+
+            return a;
+        }
+
+        int _rotate_up(int a, int child, bool child_is_left)
+        {
+            auto &node_a = _nodes[static_cast<size_t>(a)];
+            auto &node_child = _nodes[static_cast<size_t>(child)];
+
+            int other = child_is_left ? node_a.right : node_a.left;
+            int f = node_child.left;
+            int g = node_child.right;
+            auto &node_other = _nodes[static_cast<size_t>(other)];
+            auto &node_f = _nodes[static_cast<size_t>(f)];
+            auto &node_g = _nodes[static_cast<size_t>(g)];
+
+            node_child.left = a;
+            node_child.parent = node_a.parent;
+            node_a.parent = child;
+
+            if (node_child.parent != _Null) {
+                auto &parent_node = _nodes[static_cast<size_t>(node_child.parent)];
+                if (parent_node.left == a) {
+                    parent_node.left = child;
+                } else {
+                    parent_node.right = child;
+                }
+            } else {
+                _root = child;
+            }
+
+            int kept = node_f.height > node_g.height ? f : g;
+            int moved = kept == f ? g : f;
+            auto &node_kept = _nodes[static_cast<size_t>(kept)];
+            auto &node_moved = _nodes[static_cast<size_t>(moved)];
+
+            node_child.right = kept;
+            if (child_is_left) {
+                node_a.left = moved;
+            } else {
+                node_a.right = moved;
+            }
+            node_moved.parent = a;
+
+            node_a.minimum = glm::min(node_other.minimum, node_moved.minimum);
+            node_a.maximum = glm::max(node_other.maximum, node_moved.maximum);
+            node_a.height = 1 + std::max(node_other.height, node_moved.height);
+
+            node_child.minimum = glm::min(node_a.minimum, node_kept.minimum);
+            node_child.maximum = glm::max(node_a.maximum, node_kept.maximum);
+            node_child.height = 1 + std::max(node_a.height, node_kept.height);
+
+            return child;
+        }
+    };
+}
+
+#endif
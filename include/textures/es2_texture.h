@@ -2,11 +2,13 @@
 #define ES2_TEXTURE_H
 
 #include "textures/texture.h"
+#include "renderer/es2_state.h"
 
 #include <GL/glew.h>
 #define SDL_MAIN_HANDLED
 #include <SDL.h>
 
+#include <memory>
 #include <vector>
 
 namespace asr
@@ -18,23 +20,34 @@ namespace asr
             : Texture(image_data, width, height, channels)
         {}
 
+        explicit ES2Texture(const std::shared_ptr<Texture> &image_texture)
+            : Texture(image_texture)
+        {}
+
         ES2Texture(const ES2Texture &other) = delete;
         ES2Texture& operator=(const ES2Texture &other) = delete;
 
         ~ES2Texture() final
         {
             if (_texture != 0) {
+                ES2State::get_instance().on_texture_deleted(_texture);
                 glDeleteTextures(1, &_texture);
             }
         }
 
         void update(unsigned int sampler) final
         {
+            if (_image_texture) {
+                _image_texture->update(sampler);
+                return;
+            }
+
+            auto &state = ES2State::get_instance();
+
             if (_requires_data_update) {
-                glActiveTexture(GL_TEXTURE0 + sampler);
                 if (_texture == 0) {
                     glGenTextures(1, &_texture);
-                    glBindTexture(GL_TEXTURE_2D, _texture);
+                    state.bind_texture(sampler, _texture);
                     GLint format = _channels == 3 ? GL_RGB : GL_RGBA;
                     glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
                     glTexImage2D(
@@ -45,7 +58,7 @@ namespace asr
                         reinterpret_cast<GLvoid *>(_image_data.data())
                     );
                 } else {
-                    glBindTexture(GL_TEXTURE_2D, _texture);
+                    state.bind_texture(sampler, _texture);
                     GLint format = _channels == 3 ? GL_RGB : GL_RGBA;
                     glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
                     glTexSubImage2D(
@@ -59,14 +72,13 @@ namespace asr
                 if (_mipmaps_enabled) {
                     glGenerateMipmap(GL_TEXTURE_2D);
                 }
-                glBindTexture(GL_TEXTURE_2D, 0);
+                state.bind_texture(sampler, 0);
 
                 _requires_data_update = false;
             }
 
             if (_requires_params_update) {
-                glActiveTexture(GL_TEXTURE0 + sampler);
-                glBindTexture(GL_TEXTURE_2D, _texture);
+                state.bind_texture(sampler, _texture);
 
                 glTexParameteri(
                     GL_TEXTURE_2D, GL_TEXTURE_WRAP_S,
@@ -88,7 +100,7 @@ namespace asr
                     GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, static_cast<GLfloat>(_anisotropy)
                 );
 
-                glBindTexture(GL_TEXTURE_2D, 0);
+                state.bind_texture(sampler, 0);
 
                 _requires_params_update = false;
             }
@@ -96,9 +108,13 @@ namespace asr
 
         void use(unsigned int sampler) final
         {
+            if (_image_texture) {
+                _image_texture->use(sampler);
+                return;
+            }
+
             if (_texture != 0) {
-                glActiveTexture(GL_TEXTURE0 + sampler);
-                glBindTexture(GL_TEXTURE_2D, _texture);
+                ES2State::get_instance().bind_texture(sampler, _texture);
             }
         }
 
@@ -4,6 +4,7 @@
 #include <glm/glm.hpp>
 
 #include <cstdint>
+#include <memory>
 #include <vector>
 #include <utility>
 
@@ -42,8 +43,23 @@ namespace asr
             : _image_data{std::move(image_data)}, _width{width}, _height{height}, _channels{channels}
         {}
 
+        /* A view of another texture's image, such as one frame of a shared sprite sheet. Views are applied with their
+         * own mode and transformation, while the image, its size and its sampling parameters stay with the texture
+         * that owns it. */
+        explicit Texture(const std::shared_ptr<Texture> &image_texture)
+            : _width{image_texture->_width},
+              _height{image_texture->_height},
+              _channels{image_texture->_channels},
+              _image_texture{image_texture->_image_texture ? image_texture->_image_texture : image_texture}
+        {}
+
         virtual ~Texture() = default;
 
+        [[nodiscard]] const Texture *get_image_texture() const
+        {
+            return _image_texture ? _image_texture.get() : this;
+        }
+
         [[nodiscard]] const std::vector<uint8_t> &get_image_data() const
         {
             return _image_data;
@@ -246,6 +262,8 @@ namespace asr
         unsigned int _height;
         unsigned int _channels;
 
+        std::shared_ptr<Texture> _image_texture;
+
         bool _mipmaps_enabled{false};
         Mode _mode{Mode::Modulation};
         WrapMode _wrap_mode_s{ClampToEdge};
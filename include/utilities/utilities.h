@@ -3,6 +3,8 @@
 
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include "stb_image_write.h"
 
 #include <tuple>
 #include <string>
@@ -11,6 +13,12 @@
 #include <cstdlib>
 #include <sstream>
 #include <vector>
+#include <iterator>
+#include <array>
+#include <utility>
+#include <cstdint>
+#include <cstring>
+#include <cstddef>
 
 namespace asr::file_utilities
 {
@@ -30,6 +38,30 @@ namespace asr::file_utilities
         return string_stream.str();
     }
 
+    static bool read_binary_file(const std::string &path, std::vector<uint8_t> &data)
+    {
+        std::ifstream file_stream{path, std::ios::binary};
+        if (!file_stream.is_open()) {
+            return false;
+        }
+
+        data.assign(std::istreambuf_iterator<char>(file_stream), std::istreambuf_iterator<char>());
+
+        return !file_stream.bad();
+    }
+
+    static bool write_binary_file(const std::string &path, const std::vector<uint8_t> &data)
+    {
+        std::ofstream file_stream{path, std::ios::binary | std::ios::trunc};
+        if (!file_stream.is_open()) {
+            return false;
+        }
+
+        file_stream.write(reinterpret_cast<const char *>(data.data()), static_cast<std::streamsize>(data.size()));
+
+        return file_stream.good();
+    }
+
     static image_data_type read_image_file(const std::string &path)
     {
         int image_width, image_height;
@@ -51,6 +83,62 @@ namespace asr::file_utilities
 
         return std::make_tuple(result, image_width, image_height, bytes_per_pixel);
     }
+
+    static bool write_image_file(
+        const std::string &path, const std::vector<uint8_t> &data,
+        unsigned int width, unsigned int height, unsigned int bytes_per_pixel
+    )
+    {
+        int result = stbi_write_png(
+            path.c_str(),
+            static_cast<int>(width), static_cast<int>(height), static_cast<int>(bytes_per_pixel),
+            data.data(), static_cast<int>(width * bytes_per_pixel)
+        );
+        if (result == 0) {
+            std::cerr << "Failed to write the file: '" << path << "'" << std::endl;
+            return false;
+        }
+
+        return true;
+    }
+}
+
+namespace asr::sort_utilities
+{
+    template<typename T>
+    static void radix_sort(std::vector<std::pair<uint64_t, T>> &items, std::vector<std::pair<uint64_t, T>> &buffer)
+    {
+        if (items.size() < 2) {
+            return;
+        }
+
+        buffer.resize(items.size());
+        for (unsigned int shift = 0; shift < 64; shift += 8) {
+            std::array<size_t, 257> offsets{};
+            for (const auto &item : items) {
+                ++offsets[((item.first >> shift) & 0xffu) + 1];
+            }
+            if (offsets[((items.front().first >> shift) & 0xffu) + 1] == items.size()) {
+                continue;
+            }
+
+            for (size_t i = 1; i < offsets.size(); ++i) {
+                offsets[i] += offsets[i - 1];
+            }
+            for (auto &item : items) {
+                buffer[offsets[(item.first >> shift) & 0xffu]++] = std::move(item);
+            }
+            items.swap(buffer);
+        }
+    }
+
+    static uint32_t get_ordered_float_bits(float value)
+    {
+        uint32_t bits{0};
+        std::memcpy(&bits, &value, sizeof(bits));
+
+        return (bits & 0x80000000u) != 0 ? ~bits : bits | 0x80000000u;
+    }
 }
 
 #endif
@@ -0,0 +1,143 @@
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <cstddef>
+
+namespace asr
+{
+    /* A fixed set of worker threads that split index ranges with the calling thread. parallel_for blocks until every
+     * batch has been processed, so the function may reference locals of the caller. */
+    class WorkerPool final
+    {
+    public:
+        explicit WorkerPool(size_t worker_count = get_default_worker_count())
+        {
+            for (size_t i = 0; i < worker_count; ++i) {
+                _workers.emplace_back([this] { _run(); });
+            }
+        }
+
+        WorkerPool(const WorkerPool &other) = delete;
+        WorkerPool& operator=(const WorkerPool &other) = delete;
+
+        ~WorkerPool()
+        {
+            {
+                std::lock_guard<std::mutex> lock{_mutex};
+                _stopping = true;
+            }
+            _job_available.notify_all();
+
+            for (auto &worker : _workers) {
+                worker.join();
+            }
+        }
+
+        [[nodiscard]] static size_t get_default_worker_count()
+        {
+            unsigned int thread_count{std::thread::hardware_concurrency()};
+
+            return thread_count > 1 ? thread_count - 1 : 0;
+        }
+
+        [[nodiscard]] size_t get_worker_count() const
+        {
+            return _workers.size();
+        }
+
+        template<typename Function>
+        void parallel_for(size_t count, size_t minimum_batch_size, Function function)
+        {
+            size_t participant_count{_workers.size() + 1};
+            size_t batch_size{std::max(minimum_batch_size, (count + participant_count * 4 - 1) / (participant_count * 4))};
+            if (_workers.empty() || count <= batch_size) {
+                if (count > 0) {
+                    function(size_t{0}, count);
+                }
+                return;
+            }
+
+            {
+                // Workers that woke up too late for the previous job must leave before its state is replaced.
+                std::unique_lock<std::mutex> lock{_mutex};
+                _job_finished.wait(lock, [this] { return _active_worker_count == 0; });
+
+                _function = [&function](size_t begin, size_t end) { function(begin, end); };
+                _count = count;
+                _batch_size = batch_size;
+                _next_index.store(0);
+                _remaining_batch_count.store((count + batch_size - 1) / batch_size);
+                ++_job;
+            }
+            _job_available.notify_all();
+
+            _process_batches();
+
+            std::unique_lock<std::mutex> lock{_mutex};
+            _job_finished.wait(lock, [this] { return _remaining_batch_count.load() == 0 && _active_worker_count == 0; });
+            _function = nullptr;
+        }
+
+    private:
+        std::vector<std::thread> _workers;
+
+        std::mutex _mutex;
+        std::condition_variable _job_available;
+        std::condition_variable _job_finished;
+        bool _stopping{false};
+        size_t _job{0};
+        size_t _active_worker_count{0};
+
+        std::function<void(size_t, size_t)> _function;
+        size_t _count{0};
+        size_t _batch_size{1};
+        std::atomic<size_t> _next_index{0};
+        std::atomic<size_t> _remaining_batch_count{0};
+
+        void _run()
+        {
+            size_t last_job{0};
+            while (true) {
+                {
+                    std::unique_lock<std::mutex> lock{_mutex};
+                    _job_available.wait(lock, [&] { return _stopping || _job != last_job; });
+                    if (_stopping) {
+                        return;
+                    }
+                    last_job = _job;
+                    ++_active_worker_count;
+                }
+
+                _process_batches();
+
+                {
+                    std::lock_guard<std::mutex> lock{_mutex};
+                    --_active_worker_count;
+                }
+                _job_finished.notify_all();
+            }
+        }
+
+        void _process_batches()
+        {
+            while (true) {
+                size_t begin{_next_index.fetch_add(_batch_size)};
+                if (begin >= _count) {
+                    return;
+                }
+
+                _function(begin, std::min(begin + _batch_size, _count));
+                _remaining_batch_count.fetch_sub(1);
+            }
+        }
+    };
+}
+
+#endif
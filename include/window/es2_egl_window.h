@@ -0,0 +1,288 @@
+#ifndef ES2_EGL_WINDOW_H
+#define ES2_EGL_WINDOW_H
+
+#include "window/window.h"
+#include "utilities/utilities.h"
+
+#include <GL/glew.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+namespace asr
+{
+    /* An offscreen window for machines without a display. The context is created through EGL on the surfaceless Mesa
+     * platform when it is available, or with a pbuffer on the default display otherwise. Frames are rendered into a
+     * framebuffer object that stays bound as the default framebuffer and can be read back after swap(). */
+    class ES2EGLWindow final : public Window
+    {
+    public:
+        ES2EGLWindow(const std::string &name, unsigned int width, unsigned int height)
+            : Window{name, width, height}
+        {
+            if (width == FULLSCREEN || height == FULLSCREEN) {
+                std::cerr << "Offscreen windows require an explicit size." << std::endl;
+                std::exit(-1);
+            }
+
+            if (_create_surfaceless_context() || _create_pbuffer_context()) {
+                _create_framebuffer();
+            } else {
+                std::cerr << "Failed to create an offscreen EGL context." << std::endl;
+                std::exit(-1);
+            }
+
+            _on_exit = [&]() { exit(0); };
+            _on_key_down = [&](int key) { };
+            _on_late_keys_down = [&](const uint8_t *keys) { };
+            _on_mouse_move = [&](int x, int y, int x_rel, int y_rel) { };
+            _on_mouse_down = [&](int button, int x, int y) { };
+        }
+
+        ES2EGLWindow(const ES2EGLWindow &other) = delete;
+        ES2EGLWindow& operator=(const ES2EGLWindow &other) = delete;
+
+        ~ES2EGLWindow() final
+        {
+            if (_framebuffer != 0) {
+                glBindFramebuffer(GL_FRAMEBUFFER, 0);
+                glDeleteFramebuffers(1, &_framebuffer);
+                glDeleteRenderbuffers(1, &_color_renderbuffer);
+                glDeleteRenderbuffers(1, &_depth_stencil_renderbuffer);
+            }
+
+            eglMakeCurrent(_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+            if (_context != EGL_NO_CONTEXT) {
+                eglDestroyContext(_display, _context);
+            }
+            if (_surface != EGL_NO_SURFACE) {
+                eglDestroySurface(_display, _surface);
+            }
+            eglTerminate(_display);
+        }
+
+        [[nodiscard]] bool is_surfaceless() const
+        {
+            return _surface == EGL_NO_SURFACE;
+        }
+
+        [[nodiscard]] size_t get_frame() const
+        {
+            return _frame;
+        }
+
+        void poll() final
+        {
+        }
+
+        void swap() final
+        {
+            glFlush();
+            ++_frame;
+        }
+
+        // RGBA rows from top to bottom.
+        void read_pixels(std::vector<uint8_t> &pixels) const
+        {
+            size_t row_size{static_cast<size_t>(_width) * 4};
+            pixels.resize(row_size * _height);
+
+            glBindFramebuffer(GL_FRAMEBUFFER, _framebuffer);
+            glPixelStorei(GL_PACK_ALIGNMENT, 1);
+            glReadPixels(0, 0, static_cast<GLsizei>(_width), static_cast<GLsizei>(_height), GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+
+            std::vector<uint8_t> row(row_size);
+            for (unsigned int y = 0; y < _height / 2; ++y) {
+                uint8_t *top = pixels.data() + y * row_size;
+                uint8_t *bottom = pixels.data() + (_height - 1 - y) * row_size;
+                std::memcpy(row.data(), top, row_size);
+                std::memcpy(top, bottom, row_size);
+                std::memcpy(bottom, row.data(), row_size);
+            }
+        }
+
+        bool save_image(const std::string &path) const
+        {
+            std::vector<uint8_t> pixels;
+            read_pixels(pixels);
+
+            return file_utilities::write_image_file(path, pixels, _width, _height, 4);
+        }
+
+    private:
+        EGLDisplay _display{EGL_NO_DISPLAY};
+        EGLContext _context{EGL_NO_CONTEXT};
+        EGLSurface _surface{EGL_NO_SURFACE};
+
+        GLuint _framebuffer{0};
+        GLuint _color_renderbuffer{0};
+        GLuint _depth_stencil_renderbuffer{0};
+
+        size_t _frame{0};
+
+        static bool _has_extension(const char *extensions, const std::string &name)
+        {
+            if (extensions == nullptr) {
+                return false;
+            }
+
+            std::string padded_extensions{std::string{" "} + extensions + " "};
+
+            return padded_extensions.find(" " + name + " ") != std::string::npos;
+        }
+
+        bool _create_surfaceless_context()
+        {
+            const char *client_extensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+            if (!_has_extension(client_extensions, "EGL_MESA_platform_surfaceless")) {
+                return false;
+            }
+
+            auto get_platform_display = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(
+                eglGetProcAddress("eglGetPlatformDisplayEXT")
+            );
+            if (get_platform_display == nullptr) {
+                return false;
+            }
+
+            _display = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+            if (_display == EGL_NO_DISPLAY || eglInitialize(_display, nullptr, nullptr) != EGL_TRUE) {
+                _display = EGL_NO_DISPLAY;
+                return false;
+            }
+            const char *display_extensions = eglQueryString(_display, EGL_EXTENSIONS);
+            if (!_has_extension(display_extensions, "EGL_KHR_surfaceless_context")) {
+                _release_display();
+                return false;
+            }
+
+            // Contexts may only be created without a config when the display supports it.
+            EGLConfig config{nullptr};
+            if (!_choose_config(0, config) && !_has_extension(display_extensions, "EGL_KHR_no_config_context")) {
+                _release_display();
+                return false;
+            }
+
+            if (!_create_context(config, EGL_NO_SURFACE)) {
+                _release_display();
+                return false;
+            }
+
+            return true;
+        }
+
+        bool _create_pbuffer_context()
+        {
+            _display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+            if (_display == EGL_NO_DISPLAY || eglInitialize(_display, nullptr, nullptr) != EGL_TRUE) {
+                _display = EGL_NO_DISPLAY;
+                return false;
+            }
+
+            EGLConfig config{nullptr};
+            if (!_choose_config(EGL_PBUFFER_BIT, config)) {
+                _release_display();
+                return false;
+            }
+
+            EGLint surface_attributes[] = {EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE};
+            _surface = eglCreatePbufferSurface(_display, config, surface_attributes);
+            if (_surface == EGL_NO_SURFACE || !_create_context(config, _surface)) {
+                _release_display();
+                return false;
+            }
+
+            return true;
+        }
+
+        // Undoes a failed context creation, leaving the display uninitialized.
+        void _release_display()
+        {
+            if (_context != EGL_NO_CONTEXT) {
+                eglDestroyContext(_display, _context);
+                _context = EGL_NO_CONTEXT;
+            }
+            if (_surface != EGL_NO_SURFACE) {
+                eglDestroySurface(_display, _surface);
+                _surface = EGL_NO_SURFACE;
+            }
+            eglTerminate(_display);
+            _display = EGL_NO_DISPLAY;
+        }
+
+        bool _choose_config(EGLint surface_type, EGLConfig &config) const
+        {
+            EGLint config_attributes[] = {
+                EGL_SURFACE_TYPE, surface_type,
+                EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+                EGL_RED_SIZE, 8,
+                EGL_GREEN_SIZE, 8,
+                EGL_BLUE_SIZE, 8,
+                EGL_NONE
+            };
+            EGLint config_count{0};
+
+            return eglChooseConfig(_display, config_attributes, &config, 1, &config_count) == EGL_TRUE && config_count > 0;
+        }
+
+        bool _create_context(EGLConfig config, EGLSurface surface)
+        {
+            if (eglBindAPI(EGL_OPENGL_API) != EGL_TRUE) {
+                return false;
+            }
+
+            _context = eglCreateContext(_display, config, EGL_NO_CONTEXT, nullptr);
+            if (_context == EGL_NO_CONTEXT || eglMakeCurrent(_display, surface, surface, _context) != EGL_TRUE) {
+                return false;
+            }
+
+            // GLEW built for GLX reports a missing X display under EGL even though the entry points were loaded.
+            GLenum result = glewInit();
+#ifdef GLEW_ERROR_NO_GLX_DISPLAY
+            if (result == GLEW_ERROR_NO_GLX_DISPLAY) {
+                result = GLEW_OK;
+            }
+#endif
+            if (result != GLEW_OK) {
+                std::cerr << "Failed to initialize the OpenGL loader." << std::endl;
+                exit(-1);
+            }
+
+            return true;
+        }
+
+        void _create_framebuffer()
+        {
+            auto width = static_cast<GLsizei>(_width);
+            auto height = static_cast<GLsizei>(_height);
+
+            glGenFramebuffers(1, &_framebuffer);
+            glBindFramebuffer(GL_FRAMEBUFFER, _framebuffer);
+
+            glGenRenderbuffers(1, &_color_renderbuffer);
+            glBindRenderbuffer(GL_RENDERBUFFER, _color_renderbuffer);
+            glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+            glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, _color_renderbuffer);
+
+            glGenRenderbuffers(1, &_depth_stencil_renderbuffer);
+            glBindRenderbuffer(GL_RENDERBUFFER, _depth_stencil_renderbuffer);
+            glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+            glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, _depth_stencil_renderbuffer);
+            glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_STENCIL_ATTACHMENT, GL_RENDERBUFFER, _depth_stencil_renderbuffer);
+            glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+            if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+                std::cerr << "Failed to create the offscreen framebuffer." << std::endl;
+                std::exit(-1);
+            }
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,198 @@
+#include "asr.h"
+
+#include <algorithm>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include <cstdlib>
+
+using namespace asr;
+
+static std::vector<const Mesh *> sorted_by_address(const std::vector<std::shared_ptr<Mesh>> &meshes)
+{
+    std::vector<const Mesh *> addresses;
+    for (const auto &mesh : meshes) {
+        addresses.push_back(mesh.get());
+    }
+    std::sort(std::begin(addresses), std::end(addresses));
+
+    return addresses;
+}
+
+static bool is_less_or_equal(const glm::vec3 &a, const glm::vec3 &b)
+{
+    return a.x <= b.x && a.y <= b.y && a.z <= b.z;
+}
+
+static bool check(const std::string &query, const std::vector<std::shared_ptr<Mesh>> &found,
+                  const std::vector<std::shared_ptr<Mesh>> &expected)
+{
+    if (sorted_by_address(found) == sorted_by_address(expected)) {
+        return true;
+    }
+
+    std::cerr << query << " found " << found.size() << " meshes, brute force found " << expected.size() << "." << std::endl;
+
+    return false;
+}
+
+int main(int argc, char **argv)
+{
+    int mesh_count{argc > 1 ? std::atoi(argv[1]) : 500};
+    int query_count{argc > 2 ? std::atoi(argv[2]) : 200};
+
+    std::mt19937 random{42};
+    std::uniform_real_distribution<float> coordinate{-50.0f, 50.0f};
+    std::uniform_real_distribution<float> angle{0.0f, 6.28f};
+    std::uniform_real_distribution<float> scale{0.2f, 3.0f};
+    std::uniform_real_distribution<float> unit{-1.0f, 1.0f};
+
+    auto random_position = [&]() {
+        return glm::vec3{coordinate(random), coordinate(random), coordinate(random)};
+    };
+
+    // Geometries are never used for drawing here, so no context is needed.
+    auto[box_indices, box_vertices] = geometry_generators::generate_box_geometry_data(1.0f, 2.0f, 0.5f, 1, 1, 1);
+    auto box_geometry = std::make_shared<ES2Geometry>(box_indices, box_vertices);
+    auto[rectangle_indices, rectangle_vertices] = geometry_generators::generate_rectangle_geometry_data(2.0f, 2.0f, 1, 1);
+    auto rectangle_geometry = std::make_shared<ES2Geometry>(rectangle_indices, rectangle_vertices);
+
+    auto bvh = std::make_shared<BVH>();
+    std::vector<std::shared_ptr<Mesh>> meshes;
+    for (int i = 0; i < mesh_count; ++i) {
+        auto mesh = std::make_shared<Mesh>(i % 3 == 0 ? rectangle_geometry : box_geometry, nullptr);
+        mesh->set_position(random_position());
+        mesh->set_rotation(glm::vec3{angle(random), angle(random), angle(random)});
+        mesh->set_scale(glm::vec3{scale(random)});
+        if (i % 50 == 0) {
+            mesh->set_frustum_culling_enabled(false);
+        }
+        bvh->insert(mesh);
+        meshes.push_back(mesh);
+    }
+
+    // Moves, culling changes and removals go through the incremental update path.
+    for (size_t i = 0; i < meshes.size(); i += 4) {
+        meshes[i]->set_position(random_position());
+    }
+    for (size_t i = 1; i < meshes.size(); i += 25) {
+        meshes[i]->set_frustum_culling_enabled(!meshes[i]->is_frustum_culling_enabled());
+    }
+    for (size_t i = 2; i < meshes.size(); i += 10) {
+        bvh->remove(meshes[i]);
+    }
+    bvh->update();
+
+    std::vector<std::shared_ptr<Mesh>> inserted;
+    for (size_t i = 0; i < meshes.size(); ++i) {
+        if (i % 10 != 2) {
+            inserted.push_back(meshes[i]);
+        }
+    }
+    if (bvh->get_mesh_count() != inserted.size()) {
+        std::cerr << "BVH holds " << bvh->get_mesh_count() << " meshes instead of " << inserted.size() << "." << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    bool passed{true};
+    for (int query = 0; query < query_count; ++query) {
+        std::vector<std::shared_ptr<Mesh>> found, expected;
+
+        glm::vec3 eye = random_position();
+        glm::mat4 view_projection =
+            glm::perspective(0.8f, 16.0f / 9.0f, 0.1f, 60.0f) * glm::lookAt(eye, random_position(), glm::vec3{0.0f, 1.0f, 0.0f});
+        Frustum frustum{view_projection};
+        bvh->query_frustum(frustum, found);
+        for (const auto &mesh : inserted) {
+            if (!mesh->is_frustum_culling_enabled() ||
+                (frustum.intersects_sphere(mesh->get_world_bounding_sphere()) &&
+                 frustum.intersects_box(mesh->get_world_bounding_box()))) {
+                expected.push_back(mesh);
+            }
+        }
+        passed = check("Frustum query", found, expected) && passed;
+
+        found.clear();
+        expected.clear();
+        Sphere sphere{random_position(), scale(random) * 5.0f};
+        bvh->query_sphere(sphere, found);
+        for (const auto &mesh : inserted) {
+            if (!mesh->is_frustum_culling_enabled()) {
+                continue;
+            }
+            const auto &bounding_box = mesh->get_world_bounding_box();
+            glm::vec3 closest_point = glm::min(glm::max(sphere.get_center(), bounding_box.get_minimum()), bounding_box.get_maximum());
+            glm::vec3 offset = closest_point - sphere.get_center();
+            if (glm::dot(offset, offset) <= sphere.get_radius() * sphere.get_radius()) {
+                expected.push_back(mesh);
+            }
+        }
+        passed = check("Sphere query", found, expected) && passed;
+
+        found.clear();
+        expected.clear();
+        glm::vec3 corner = random_position();
+        AABB box{corner, corner + glm::vec3{scale(random), scale(random), scale(random)} * 8.0f};
+        bvh->query_box(box, found);
+        for (const auto &mesh : inserted) {
+            if (!mesh->is_frustum_culling_enabled()) {
+                continue;
+            }
+            const auto &bounding_box = mesh->get_world_bounding_box();
+            if (is_less_or_equal(bounding_box.get_minimum(), box.get_maximum()) &&
+                is_less_or_equal(box.get_minimum(), bounding_box.get_maximum())) {
+                expected.push_back(mesh);
+            }
+        }
+        passed = check("Box query", found, expected) && passed;
+
+        found.clear();
+        expected.clear();
+        Ray ray{eye, glm::normalize(glm::vec3{unit(random), unit(random), unit(random)})};
+        bvh->query_ray(ray, found);
+        for (const auto &mesh : inserted) {
+            if (mesh->is_frustum_culling_enabled() && ray.intersects_with_box(mesh->get_world_bounding_box()).first) {
+                expected.push_back(mesh);
+            }
+        }
+        passed = check("Ray query", found, expected) && passed;
+
+        for (size_t i = 1; i < found.size(); ++i) {
+            if (ray.intersects_with_box(found[i - 1]->get_world_bounding_box()).second >
+                ray.intersects_with_box(found[i]->get_world_bounding_box()).second) {
+                std::cerr << "Ray query hits are not sorted by distance." << std::endl;
+                passed = false;
+                break;
+            }
+        }
+    }
+
+    // Vertices edited in place grow the mesh without moving it or swapping its geometry.
+    auto grown_geometry = std::make_shared<ES2Geometry>(box_indices, box_vertices);
+    auto grown_mesh = std::make_shared<Mesh>(grown_geometry, nullptr);
+    grown_mesh->set_position(glm::vec3{200.0f});
+    bvh->insert(grown_mesh);
+    bvh->update();
+
+    auto &grown_vertices = grown_geometry->get_vertices();
+    for (auto &vertex : grown_vertices) {
+        vertex.position *= 20.0f;
+    }
+    grown_geometry->mark_vertices_dirty(0, grown_vertices.size());
+    bvh->update();
+
+    std::vector<std::shared_ptr<Mesh>> grown_found;
+    bvh->query_box(AABB{glm::vec3{208.0f, 215.0f, 203.0f}, glm::vec3{209.0f, 216.0f, 204.0f}}, grown_found);
+    if (std::find(std::begin(grown_found), std::end(grown_found), grown_mesh) == std::end(grown_found)) {
+        std::cerr << "Box query missed a mesh whose vertices were edited in place." << std::endl;
+        passed = false;
+    }
+
+    std::cout << "BVH of " << bvh->get_mesh_count() << " meshes with height " << bvh->get_height() << ", "
+              << query_count << " queries of each kind " << (passed ? "match" : "do not match")
+              << " brute force." << std::endl;
+
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
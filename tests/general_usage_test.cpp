@@ -17,7 +17,7 @@ const glm::vec4 RIGHT{1.0f, 0.0f, 0.0f, 0.0f};
 
 class Enemy {
 public:
-    typedef std::tuple<const std::string, unsigned int, unsigned int> enemy_sprite_data_type;
+    typedef std::tuple<std::shared_ptr<Texture>, unsigned int, unsigned int> enemy_sprite_data_type;
 
     enum State {
         Alive,
@@ -28,12 +28,10 @@ public:
     Enemy(const glm::vec3 &position, float size, float speed, const enemy_sprite_data_type& enemy_sprite_data)
         : _position{position}, _speed(speed)
     {
-        const auto&[sprite_file, sprite_frame_count, first_dying_state_sprite_frame] = enemy_sprite_data;
+        const auto&[sprite_sheet, sprite_frame_count, first_dying_state_sprite_frame] = enemy_sprite_data;
 
-        auto[image_data, image_width, image_height, image_channels] = file_utilities::read_image_file(sprite_file);
-        _texture = std::make_shared<ES2Texture>(image_data, image_width, image_height, image_channels);
-        _texture->set_minification_filter(Texture::FilterType::Nearest);
-        _texture->set_magnification_filter(Texture::FilterType::Nearest);
+        // Every enemy animates its own view of the shared sprite sheet, so their billboards can still be batched.
+        _texture = std::make_shared<ES2Texture>(sprite_sheet);
         _texture->set_mode(Texture::Mode::Modulation);
         _texture->set_transformation_enabled(true);
         _set_texture_frames(sprite_frame_count);
@@ -49,7 +47,6 @@ public:
 
         _mesh = std::make_shared<Mesh>(billboard_geometry, billboard_material);
         _mesh->set_position(position);
-        _bounding_volume = Sphere{_mesh->get_position(), size / 2};
     }
 
     [[nodiscard]] const std::shared_ptr<Mesh> &get_mesh() const
@@ -94,17 +91,11 @@ public:
             _velocity = glm::normalize(target - position) * _speed * delta_time;
             _position += _velocity * delta_time;
             _mesh->set_position(_position);
-            _bounding_volume.set_center(_position);
         }
 
         _mesh->billboard_toward_camera(_target);
     }
 
-    [[nodiscard]] bool intersects_with_ray(const Ray &ray) const
-    {
-        return ray.intersects_with_sphere(_bounding_volume).first;
-    }
-
     void kill()
     {
         if (_state == Alive) {
@@ -121,7 +112,6 @@ private:
     glm::vec3 _velocity{0.0f};
 
     std::shared_ptr<Mesh> _mesh;
-    Sphere _bounding_volume{glm::vec3{0.0f}, 1.0f};
 
     std::shared_ptr<Camera> _target{nullptr};
 
@@ -221,7 +211,7 @@ public:
         }
     }
 
-    void shoot(const std::vector<std::shared_ptr<Enemy>> &enemies)
+    void shoot(BVH &bvh, const std::vector<std::shared_ptr<Enemy>> &enemies)
     {
         if (_state == Idling) {
             _state = Shooting;
@@ -230,13 +220,20 @@ public:
                 return;
             }
 
-            for (auto &enemy : enemies) {
-                if (enemy->intersects_with_ray(_point_of_view->world_ray_from_screen_point(
-                        static_cast<int>(_target.x),
-                        static_cast<int>(_target.y)
-                    ))) {
-                    enemy->kill();
-                    return;
+            bvh.update();
+
+            std::vector<std::shared_ptr<Mesh>> hit_meshes;
+            bvh.query_ray(_point_of_view->world_ray_from_screen_point(
+                static_cast<int>(_target.x),
+                static_cast<int>(_target.y)
+            ), hit_meshes);
+
+            for (auto &mesh : hit_meshes) {
+                for (auto &enemy : enemies) {
+                    if (enemy->get_mesh() == mesh) {
+                        enemy->kill();
+                        return;
+                    }
                 }
             }
         }
@@ -319,9 +316,16 @@ int main(int argc, char **argv)
     float enemies_speed = 10.01f;
     int enemies_sprite_frames = 10;
     int enemies_dying_first_sprite_frame = 4;
-    std::tuple enemies_sprite_data =
+    auto[enemies_image_data, enemies_image_width, enemies_image_height, enemies_image_channels] =
+        file_utilities::read_image_file("data/images/cacodemon.png");
+    auto enemies_sprite_sheet = std::make_shared<ES2Texture>(
+        enemies_image_data, enemies_image_width, enemies_image_height, enemies_image_channels
+    );
+    enemies_sprite_sheet->set_minification_filter(Texture::FilterType::Nearest);
+    enemies_sprite_sheet->set_magnification_filter(Texture::FilterType::Nearest);
+    Enemy::enemy_sprite_data_type enemies_sprite_data =
         std::make_tuple(
-            "data/images/cacodemon.png",
+            std::shared_ptr<Texture>{enemies_sprite_sheet},
             enemies_sprite_frames,
             enemies_dying_first_sprite_frame
         );
@@ -431,6 +435,11 @@ int main(int argc, char **argv)
     }
     Mix_PlayMusic(music, -1);
 
+    // Renderer
+
+    ES2Renderer renderer(scene, window);
+    renderer.set_occlusion_culling_enabled(true);
+
     // Input
 
     window->set_on_late_keys_down([&](const uint8_t *keys) {
@@ -452,7 +461,7 @@ int main(int argc, char **argv)
 
     window->set_on_mouse_down([&](int button, int x, int y) {
         Mix_PlayChannel(-1, shotgun_sound, 0);
-        gun->shoot(enemies);
+        gun->shoot(*renderer.get_bvh(), enemies);
     });
 
     window->set_on_mouse_move([&](int x, int y, int x_rel, int y_rel) {
@@ -463,7 +472,6 @@ int main(int argc, char **argv)
 
     auto prev_frame_time = std::chrono::high_resolution_clock::now();
 
-    ES2Renderer renderer(scene, window);
     while (true) {
         window->poll();
 
@@ -0,0 +1,122 @@
+#include "asr.h"
+
+#include <algorithm>
+#include <array>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <cstring>
+
+using namespace asr;
+
+typedef std::array<float, sizeof(Vertex) / sizeof(float)> vertex_key_type;
+typedef std::array<vertex_key_type, 3> triangle_key_type;
+
+// Triangles by the values of their corners, rotated to start at the smallest corner so that the winding is kept.
+static std::vector<triangle_key_type> get_triangles(const std::vector<unsigned int> &indices, const std::vector<Vertex> &vertices)
+{
+    std::vector<triangle_key_type> triangles;
+    for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+        triangle_key_type triangle;
+        for (size_t corner = 0; corner < 3; ++corner) {
+            std::memcpy(triangle[corner].data(), &vertices[indices[i + corner]], sizeof(Vertex));
+        }
+        if (triangle[0] == triangle[1] || triangle[1] == triangle[2] || triangle[2] == triangle[0]) {
+            continue;
+        }
+
+        std::rotate(std::begin(triangle), std::min_element(std::begin(triangle), std::end(triangle)), std::end(triangle));
+        triangles.push_back(triangle);
+    }
+    std::sort(std::begin(triangles), std::end(triangles));
+
+    return triangles;
+}
+
+static bool check(const std::string &name, std::vector<unsigned int> indices, std::vector<Vertex> vertices, size_t cache_size)
+{
+    auto expected_triangles = get_triangles(indices, vertices);
+    auto expected_acmr = geometry_optimizers::analyze_vertex_cache(indices, vertices.size(), cache_size).acmr;
+
+    auto geometry = std::make_shared<ES2Geometry>(indices, vertices);
+    auto statistics = geometry->optimize(cache_size);
+    const auto &optimized_indices = geometry->get_indices();
+    const auto &optimized_vertices = geometry->get_vertices();
+
+    bool passed{true};
+    if (std::any_of(std::begin(optimized_indices), std::end(optimized_indices), [&](unsigned int index) {
+        return index >= optimized_vertices.size();
+    })) {
+        std::cerr << name << ": an index is out of range." << std::endl;
+        passed = false;
+    } else if (get_triangles(optimized_indices, optimized_vertices) != expected_triangles) {
+        std::cerr << name << ": the triangles or their winding changed." << std::endl;
+        passed = false;
+    }
+
+    auto acmr = geometry_optimizers::analyze_vertex_cache(optimized_indices, optimized_vertices.size(), cache_size).acmr;
+    if (acmr > expected_acmr) {
+        std::cerr << name << ": ACMR got worse, " << expected_acmr << " -> " << acmr << "." << std::endl;
+        passed = false;
+    }
+    if (statistics.before.acmr != expected_acmr || statistics.after.acmr != acmr) {
+        std::cerr << name << ": the reported ACMR " << statistics.before.acmr << " -> " << statistics.after.acmr
+                  << " does not match the measured " << expected_acmr << " -> " << acmr << "." << std::endl;
+        passed = false;
+    }
+
+    std::cout << name << " with a cache of " << cache_size << ": ACMR " << expected_acmr << " -> " << acmr
+              << ", ATVR " << statistics.before.atvr << " -> " << statistics.after.atvr
+              << (passed ? "." : ", failed.") << std::endl;
+
+    return passed;
+}
+
+static void shuffle_triangles(std::vector<unsigned int> &indices, std::mt19937 &random)
+{
+    std::vector<std::array<unsigned int, 3>> triangles;
+    for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+        triangles.push_back({indices[i], indices[i + 1], indices[i + 2]});
+    }
+    std::shuffle(std::begin(triangles), std::end(triangles), random);
+
+    indices.clear();
+    for (const auto &triangle : triangles) {
+        indices.insert(std::end(indices), std::begin(triangle), std::end(triangle));
+    }
+}
+
+int main()
+{
+    std::mt19937 random{42};
+
+    auto[rectangle_indices, rectangle_vertices] = geometry_generators::generate_rectangle_geometry_data(10.0f, 10.0f, 40, 40);
+    auto[box_indices, box_vertices] = geometry_generators::generate_box_geometry_data(1.0f, 2.0f, 3.0f, 8, 8, 8);
+    auto[sphere_indices, sphere_vertices] = geometry_generators::generate_sphere_geometry_data(1.0f, 48, 32);
+
+    auto shuffled_sphere_indices = sphere_indices;
+    shuffle_triangles(shuffled_sphere_indices, random);
+
+    // A degenerate triangle and a copy of the first vertex that should be merged away.
+    auto degenerate_box_indices = box_indices;
+    degenerate_box_indices.insert(std::end(degenerate_box_indices), {0, 0, 1});
+    auto duplicated_box_vertices = box_vertices;
+    duplicated_box_vertices.push_back(box_vertices[0]);
+    degenerate_box_indices.insert(std::end(degenerate_box_indices), {
+        static_cast<unsigned int>(duplicated_box_vertices.size() - 1), box_indices[1], box_indices[2]
+    });
+
+    bool passed{true};
+    for (size_t cache_size : {size_t{8}, geometry_optimizers::DefaultVertexCacheSize, size_t{32}}) {
+        passed = check("Rectangle", rectangle_indices, rectangle_vertices, cache_size) && passed;
+        passed = check("Box", box_indices, box_vertices, cache_size) && passed;
+        passed = check("Box with degenerate triangles", degenerate_box_indices, duplicated_box_vertices, cache_size) && passed;
+        passed = check("Sphere", sphere_indices, sphere_vertices, cache_size) && passed;
+        passed = check("Shuffled sphere", shuffled_sphere_indices, sphere_vertices, cache_size) && passed;
+    }
+
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
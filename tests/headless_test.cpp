@@ -0,0 +1,111 @@
+#include "asr.h"
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstdlib>
+
+int main(int argc, char **argv)
+{
+    using namespace asr;
+
+    int frame_count{argc > 1 ? std::atoi(argv[1]) : 60};
+    std::string image_path{argc > 2 ? argv[2] : "headless_test.png"};
+
+    auto window = std::make_shared<ES2EGLWindow>("asr 2.0", 1280, 720);
+
+    // Submitted first without depth testing, the background must stay behind everything drawn after it.
+    auto[background_indices, background_vertices] = geometry_generators::generate_rectangle_geometry_data(200.0f, 200.0f, 1, 1);
+    auto background_geometry = std::make_shared<ES2Geometry>(background_indices, background_vertices);
+    auto background_material = std::make_shared<ES2ConstantMaterial>();
+    background_material->set_emission_color(glm::vec4{0.0f, 0.0f, 1.0f, 1.0f});
+    background_material->set_depth_test_enabled(false);
+    auto background = std::make_shared<Mesh>(background_geometry, background_material);
+    background->set_z(-50.0f);
+
+    auto[plane_indices, plane_vertices] = geometry_generators::generate_rectangle_geometry_data(20.0f, 20.0f, 10, 10);
+    auto plane_geometry = std::make_shared<ES2Geometry>(plane_indices, plane_vertices);
+    auto plane_material = std::make_shared<ES2PhongMaterial>();
+    plane_material->set_diffuse_color(glm::vec4{0.4f, 0.4f, 0.4f, 1.0f});
+    auto plane = std::make_shared<Mesh>(plane_geometry, plane_material);
+    plane->set_y(-1.0f);
+    plane->set_rotation_x(-static_cast<float>(M_PI) * 0.5f);
+
+    auto[sphere_indices, sphere_vertices] = geometry_generators::generate_sphere_geometry_data(0.5f, 20, 20);
+    auto sphere_geometry = std::make_shared<ES2Geometry>(sphere_indices, sphere_vertices);
+    sphere_geometry->set_vertex_layout(VertexLayout::get_compact_layout());
+    sphere_geometry->optimize();
+    auto sphere_material = std::make_shared<ES2PhongMaterial>();
+    sphere_material->set_diffuse_color(glm::vec4{1.0f, 0.3f, 0.2f, 1.0f});
+    sphere_material->set_specular_exponent(30.0f);
+
+    std::vector<std::shared_ptr<Object>> objects{background, plane};
+    std::vector<std::shared_ptr<Mesh>> spheres;
+    for (int i = 0; i < 5; ++i) {
+        auto sphere = std::make_shared<Mesh>(sphere_geometry, sphere_material);
+        sphere->set_x(static_cast<float>(i - 2) * 1.5f);
+        objects.push_back(sphere);
+        spheres.push_back(sphere);
+    }
+
+    auto[glass_indices, glass_vertices] = geometry_generators::generate_box_geometry_data(8.0f, 2.0f, 0.1f, 1, 1, 1);
+    auto glass_geometry = std::make_shared<ES2Geometry>(glass_indices, glass_vertices);
+    auto glass_material = std::make_shared<ES2ConstantMaterial>();
+    glass_material->set_emission_color(glm::vec4{0.3f, 0.6f, 1.0f, 0.4f});
+    glass_material->set_blending_enabled(true);
+    glass_material->set_transparent(true);
+    auto glass = std::make_shared<Mesh>(glass_geometry, glass_material);
+    glass->set_z(1.5f);
+    objects.push_back(glass);
+
+    auto scene = std::make_shared<Scene>(objects);
+    scene->set_clear_color(glm::vec4{0.1f, 0.1f, 0.15f, 1.0f});
+
+    auto point_light = std::make_shared<PointLight>();
+    point_light->set_intensity(1.0f);
+    point_light->set_y(3.0f);
+    point_light->set_z(3.0f);
+    scene->get_root()->add_child(point_light);
+    scene->get_point_lights().push_back(point_light);
+
+    auto camera = scene->get_camera();
+    camera->set_y(2.0f);
+    camera->set_z(8.0f);
+    camera->set_rotation_x(-0.25f);
+
+    ES2Renderer renderer(scene, window);
+
+    auto start_time = std::chrono::high_resolution_clock::now();
+    for (int frame = 0; frame < frame_count; ++frame) {
+        window->poll();
+
+        for (auto &sphere : spheres) {
+            sphere->add_to_rotation_y(0.05f);
+        }
+
+        renderer.render();
+    }
+    glFinish();
+    auto end_time = std::chrono::high_resolution_clock::now();
+
+    std::chrono::duration<double, std::milli> time_span = end_time - start_time;
+    std::cout << "Rendered " << frame_count << " frames in " << time_span.count() << " ms ("
+              << (window->is_surfaceless() ? "surfaceless" : "pbuffer") << " context)." << std::endl;
+
+    if (!window->save_image(image_path)) {
+        return EXIT_FAILURE;
+    }
+
+    // The middle sphere covers the centre of the image behind the glass.
+    std::vector<uint8_t> pixels;
+    window->read_pixels(pixels);
+    const uint8_t *centre = pixels.data() + (static_cast<size_t>(window->get_height() / 2) * window->get_width() + window->get_width() / 2) * 4;
+    if (centre[0] < 50 && centre[2] > 240) {
+        std::cerr << "The background drawn without depth testing covers the scene." << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return glGetError() == GL_NO_ERROR ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -15,12 +15,20 @@
     plane->set_y(-2.0f);
     plane->set_rotation_x(-static_cast<float>(M_PI) * 0.5f);
 
-    auto[sphere_indices, sphere_vertices] = geometry_generators::generate_sphere_geometry_data(1.0f, 100, 100);
-    auto sphere_geometry = std::make_shared<ES2Geometry>(sphere_indices, sphere_vertices);
-    auto sphere = std::make_shared<Mesh>(sphere_geometry, material);
+    auto sphere_lod_data = geometry_generators::generate_sphere_lod_geometry_data(1.0f, 100, 100, 4);
+    std::vector<Mesh::Level> sphere_levels;
+    std::vector<float> sphere_screen_sizes{0.5f, 0.25f, 0.1f, 0.0f};
+    for (size_t i = 0; i < sphere_lod_data.size(); ++i) {
+        auto &[sphere_indices, sphere_vertices] = sphere_lod_data[i];
+        sphere_levels.push_back({std::make_shared<ES2Geometry>(sphere_indices, sphere_vertices), sphere_screen_sizes[i]});
+    }
+    auto sphere = std::make_shared<Mesh>(sphere_levels.front().geometry, material);
+    sphere->set_levels(sphere_levels);
+    sphere->set_level_hysteresis(0.1f);
 
     auto[lamp_indices, lamp_vertices] = geometry_generators::generate_sphere_geometry_data(0.1f, 20, 20);
     auto lamp_sphere_geometry = std::make_shared<ES2Geometry>(lamp_indices, lamp_vertices);
+    lamp_sphere_geometry->set_vertex_layout(VertexLayout::get_position_layout());
     auto lamp_material = std::make_shared<ES2ConstantMaterial>();
     lamp_material->set_emission_color(glm::vec4(1.0f));
     auto lamp1 = std::make_shared<Mesh>(lamp_sphere_geometry, lamp_material);
@@ -42,6 +42,7 @@
 
         auto second = std::make_shared<Mesh>(circle_geometry, seconds_material, glm::vec3{x, y, 0.0f});
         second->set_name("second");
+        second->set_static(true);
 
         objects.push_back(second);
     }
@@ -55,6 +56,7 @@
         hours->set_rotation_z(static_cast<float>(M_PI) / 4.0f);
         hours->set_z(0.2f);
         hours->set_name("hours");
+        hours->set_static(true);
 
         objects.push_back(hours);
     }
@@ -67,6 +69,7 @@
         quarter->set_rotation_z(static_cast<float>(M_PI) / 4.0f);
         quarter->set_z(0.1f);
         quarter->set_name("quarter");
+        quarter->set_static(true);
 
         objects.push_back(quarter);
     }
@@ -145,6 +148,8 @@
     });
 
     ES2Renderer renderer(scene, window);
+    // The clock face never moves relative to the root, so its marks are merged into one draw per material.
+    renderer.set_static_batching_enabled(true);
 
     while (true) {
         window->poll();